@@ -22,6 +22,11 @@ void CCliControlService::setTimeout(const std::chrono::seconds& _timeout)
     m_service->setTimeout(_timeout);
 }
 
+void CCliControlService::setDeviceWalk(bool _deviceWalk)
+{
+    m_service->setDeviceWalk(_deviceWalk);
+}
+
 void CCliControlService::registerResourcePlugins(const odc::core::CDDSSubmit::PluginMap_t& _pluginMap)
 {
     m_service->registerResourcePlugins(_pluginMap);
@@ -146,6 +151,21 @@ string CCliControlService::generalReply(const SReturnValue& _value)
                << "; state: " << state.m_status.state << " }" << endl;
         }
         ss << endl;
+
+        const auto& stats = _value.m_details->m_transitionStats;
+        if (stats.reached + stats.pending > 0)
+        {
+            ss << "  Transition latencies (" << stats.transition << "): { reached: " << stats.reached
+               << "; pending: " << stats.pending << "; p50: " << stats.p50.count() << " us; p95: " << stats.p95.count()
+               << " us; p99: " << stats.p99.count() << " us; max: " << stats.max.count() << " us }" << endl;
+            ss << "  Slowest devices: " << endl;
+            for (const auto& device : stats.slowest)
+            {
+                ss << "    { id: " << device.taskId << "; latency: " << device.latency.count() << " us"
+                   << (device.reached ? "" : "; pending") << " }" << endl;
+            }
+            ss << endl;
+        }
     }
 
     ss << "  Execution time: " << _value.m_execTime << " msec" << endl;
@@ -20,6 +20,7 @@ namespace odc::cli
         CCliControlService();
 
         void setTimeout(const std::chrono::seconds& _timeout);
+        void setDeviceWalk(bool _deviceWalk);
 
         void registerResourcePlugins(const odc::core::CDDSSubmit::PluginMap_t& _pluginMap);
 
@@ -28,6 +28,7 @@ int main(int argc, char** argv)
     try
     {
         size_t timeout;
+        bool deviceWalk;
         CLogger::SConfig logConfig;
         CCliHelper::SBatchOptions bopt;
         bool batch;
@@ -38,6 +39,7 @@ int main(int argc, char** argv)
         CCliHelper::addHelpOptions(options);
         CCliHelper::addVersionOptions(options);
         CCliHelper::addTimeoutOptions(options, timeout);
+        CCliHelper::addDeviceWalkOptions(options, deviceWalk);
         CCliHelper::addLogOptions(options, logConfig);
         CCliHelper::addBatchOptions(options, bopt, batch);
         CCliHelper::addResourcePluginOptions(options, pluginMap);
@@ -74,6 +76,7 @@ int main(int argc, char** argv)
 
         odc::cli::CCliControlService control;
         control.setTimeout(chrono::seconds(timeout));
+        control.setDeviceWalk(deviceWalk);
         control.registerResourcePlugins(pluginMap);
         control.run(bopt.m_outputCmds);
     }
@@ -66,6 +66,14 @@ void CCliHelper::addTimeoutOptions(boost::program_options::options_description&
     _options.add_options()("timeout", bpo::value<size_t>(&_timeout)->default_value(30), "Timeout of requests in sec");
 }
 
+void CCliHelper::addDeviceWalkOptions(boost::program_options::options_description& _options, bool& _deviceWalk)
+{
+    _options.add_options()("device-walk",
+                           bpo::bool_switch(&_deviceWalk)->default_value(false),
+                           "Let devices walk configure and reset to the target state on their own, requires ODC "
+                           "plugins supporting change_state_to");
+}
+
 void CCliHelper::addHostOptions(bpo::options_description& _options, string& _host)
 {
     _options.add_options()("host", bpo::value<string>(&_host)->default_value("localhost:50051"), "Server address");
@@ -52,6 +52,7 @@ namespace odc::core
         static void addHostOptions(boost::program_options::options_description& _options, std::string& _host);
         static void addLogOptions(boost::program_options::options_description& _options, CLogger::SConfig& _config);
         static void addTimeoutOptions(boost::program_options::options_description& _options, size_t& _timeout);
+        static void addDeviceWalkOptions(boost::program_options::options_description& _options, bool& _deviceWalk);
         static void addOptions(boost::program_options::options_description& _options, SBatchOptions& _batchOptions);
         static void addBatchOptions(boost::program_options::options_description& _options,
                                     SBatchOptions& _batchOptions,
@@ -9,9 +9,13 @@
 #include "Logger.h"
 #include "TimeMeasure.h"
 #include "Topology.h"
+#include "TransitionHistory.h"
 // DDS
 #include <dds/Tools.h>
 #include <dds/Topology.h>
+// STD
+#include <algorithm>
+#include <mutex>
 
 using namespace odc;
 using namespace odc::core;
@@ -38,6 +42,8 @@ struct CControlService::SImpl
         DDSSessionPtr_t m_session{ nullptr };            ///< DDS session
         FairMQTopologyPtr_t m_fairmqTopology{ nullptr }; ///< FairMQ topology
         partitionID_t m_partitionID;                     ///< External partition ID of this DDS session
+
+        CTransitionHistory m_transitionHistory; ///< Durations of the latest successful change state requests
     };
 
     SImpl()
@@ -54,6 +60,11 @@ struct CControlService::SImpl
         m_timeout = _timeout;
     }
 
+    void setDeviceWalk(bool _deviceWalk)
+    {
+        m_deviceWalk = _deviceWalk;
+    }
+
     void registerResourcePlugins(const CDDSSubmit::PluginMap_t& _pluginMap);
 
     // Core API calls
@@ -106,7 +117,15 @@ struct CControlService::SImpl
                      TopologyTransition _transition,
                      const std::string& _path,
                      AggregatedTopologyState& _aggregatedState,
-                     TopologyState* _topologyState = nullptr);
+                     TopologyState* _topologyState = nullptr,
+                     TransitionLatencyStats* _transitionStats = nullptr);
+    bool changeStateSequence(const partitionID_t& _partitionID,
+                             SError& _error,
+                             const std::vector<TopologyTransition>& _transitions,
+                             const std::string& _path,
+                             AggregatedTopologyState& _aggregatedState,
+                             TopologyState* _topologyState = nullptr,
+                             TransitionLatencyStats* _transitionStats = nullptr);
     bool getState(const partitionID_t& _partitionID,
                   SError& _error,
                   const string& _path,
@@ -116,18 +135,18 @@ struct CControlService::SImpl
                               SError& _error,
                               const std::string& _path,
                               AggregatedTopologyState& _aggregatedState,
-                              TopologyState* _topologyState = nullptr);
+                              TopologyState* _topologyState = nullptr,
+                              TransitionLatencyStats* _transitionStats = nullptr);
     bool changeStateReset(const partitionID_t& _partitionID,
                           SError& _error,
                           const std::string& _path,
                           AggregatedTopologyState& _aggregatedState,
-                          TopologyState* _topologyState = nullptr);
+                          TopologyState* _topologyState = nullptr,
+                          TransitionLatencyStats* _transitionStats = nullptr);
 
     void fillError(SError& _error, ErrorCode _errorCode, const string& _msg);
 
-    AggregatedTopologyState aggregateStateForPath(const DDSTopologyPtr_t& _topo,
-                                                  const FairMQTopologyState& _fairmq,
-                                                  const string& _path);
+    AggregatedTopologyState aggregateStateForPath(const FairMQTopologyPtr_t& _topo, const string& _path);
     void fairMQToODCTopologyState(const DDSTopologyPtr_t& _topo,
                                   const FairMQTopologyState& _fairmq,
                                   TopologyState* _odc);
@@ -136,7 +155,7 @@ struct CControlService::SImpl
 
     SError checkSessionIsRunning(const partitionID_t& _partitionID, ErrorCode _errorCode);
 
-    string stateSummaryString(const FairMQTopologyState& _topologyState,
+    string stateSummaryString(const FairMQTopologyPtr_t& _fairmqTopology,
                               DeviceState _expectedState,
                               DDSTopologyPtr_t _topo);
 
@@ -150,6 +169,7 @@ struct CControlService::SImpl
 
     SSessionInfo::Map_t m_sessions;                          ///< Map of partition ID to session info
     chrono::seconds m_timeout{ 30 };                         ///< Request timeout in sec
+    bool m_deviceWalk{ false };                              ///< Multi-transition requests use change_state_to
     CDDSSubmit::Ptr_t m_submit{ make_shared<CDDSSubmit>() }; ///< ODC to DDS submit resource converter
 };
 
@@ -326,8 +346,12 @@ SReturnValue CControlService::SImpl::execConfigure(const partitionID_t& _partiti
     AggregatedTopologyState state{ AggregatedTopologyState::Undefined };
     SReturnDetails::ptr_t details((_params.m_detailed) ? make_shared<SReturnDetails>() : nullptr);
     SError error;
-    changeStateConfigure(
-        _partitionID, error, _params.m_path, state, ((details == nullptr) ? nullptr : &details->m_topologyState));
+    changeStateConfigure(_partitionID,
+                         error,
+                         _params.m_path,
+                         state,
+                         ((details == nullptr) ? nullptr : &details->m_topologyState),
+                         ((details == nullptr) ? nullptr : &details->m_transitionStats));
     return createReturnValue(_partitionID, error, "ConfigureRun done", measure.duration(), state, details);
 }
 
@@ -342,7 +366,8 @@ SReturnValue CControlService::SImpl::execStart(const partitionID_t& _partitionID
                 TopologyTransition::Run,
                 _params.m_path,
                 state,
-                ((details == nullptr) ? nullptr : &details->m_topologyState));
+                ((details == nullptr) ? nullptr : &details->m_topologyState),
+                ((details == nullptr) ? nullptr : &details->m_transitionStats));
     return createReturnValue(_partitionID, error, "Start done", measure.duration(), state, details);
 }
 
@@ -357,7 +382,8 @@ SReturnValue CControlService::SImpl::execStop(const partitionID_t& _partitionID,
                 TopologyTransition::Stop,
                 _params.m_path,
                 state,
-                ((details == nullptr) ? nullptr : &details->m_topologyState));
+                ((details == nullptr) ? nullptr : &details->m_topologyState),
+                ((details == nullptr) ? nullptr : &details->m_transitionStats));
     return createReturnValue(_partitionID, error, "Stop done", measure.duration(), state, details);
 }
 
@@ -367,8 +393,12 @@ SReturnValue CControlService::SImpl::execReset(const partitionID_t& _partitionID
     AggregatedTopologyState state{ AggregatedTopologyState::Undefined };
     SReturnDetails::ptr_t details((_params.m_detailed) ? make_shared<SReturnDetails>() : nullptr);
     SError error;
-    changeStateReset(
-        _partitionID, error, _params.m_path, state, ((details == nullptr) ? nullptr : &details->m_topologyState));
+    changeStateReset(_partitionID,
+                     error,
+                     _params.m_path,
+                     state,
+                     ((details == nullptr) ? nullptr : &details->m_topologyState),
+                     ((details == nullptr) ? nullptr : &details->m_transitionStats));
     return createReturnValue(_partitionID, error, "Reset done", measure.duration(), state, details);
 }
 
@@ -383,7 +413,8 @@ SReturnValue CControlService::SImpl::execTerminate(const partitionID_t& _partiti
                 TopologyTransition::End,
                 _params.m_path,
                 state,
-                ((details == nullptr) ? nullptr : &details->m_topologyState));
+                ((details == nullptr) ? nullptr : &details->m_topologyState),
+                ((details == nullptr) ? nullptr : &details->m_transitionStats));
     return createReturnValue(_partitionID, error, "Terminate done", measure.duration(), state, details);
 }
 
@@ -408,10 +439,9 @@ SStatusReturnValue CControlService::SImpl::execStatus(const SStatusParams& /* _p
         }
         try
         {
-            status.m_aggregatedState =
-                (info->m_fairmqTopology != nullptr && info->m_topo != nullptr)
-                    ? aggregateStateForPath(info->m_topo, info->m_fairmqTopology->GetCurrentState(), "")
-                    : AggregatedTopologyState::Undefined;
+            status.m_aggregatedState = (info->m_fairmqTopology != nullptr && info->m_topo != nullptr)
+                                           ? info->m_fairmqTopology->AggregateState()
+                                           : AggregatedTopologyState::Undefined;
         }
         catch (exception& _e)
         {
@@ -718,7 +748,20 @@ bool CControlService::SImpl::changeState(const partitionID_t& _partitionID,
                                          TopologyTransition _transition,
                                          const string& _path,
                                          AggregatedTopologyState& _aggregatedState,
-                                         TopologyState* _topologyState)
+                                         TopologyState* _topologyState,
+                                         TransitionLatencyStats* _transitionStats)
+{
+    return changeStateSequence(
+        _partitionID, _error, { _transition }, _path, _aggregatedState, _topologyState, _transitionStats);
+}
+
+bool CControlService::SImpl::changeStateSequence(const partitionID_t& _partitionID,
+                                                 SError& _error,
+                                                 const vector<TopologyTransition>& _transitions,
+                                                 const string& _path,
+                                                 AggregatedTopologyState& _aggregatedState,
+                                                 TopologyState* _topologyState,
+                                                 TransitionLatencyStats* _transitionStats)
 {
     auto info{ getOrCreateSessionInfo(_partitionID) };
     if (info->m_fairmqTopology == nullptr)
@@ -727,27 +770,42 @@ bool CControlService::SImpl::changeState(const partitionID_t& _partitionID,
         return false;
     }
 
-    auto it{ expectedState.find(_transition) };
-    DeviceState _expectedState{ it != expectedState.end() ? it->second : DeviceState::Undefined };
-    if (_expectedState == DeviceState::Undefined)
+    stringstream transitionsStr;
+    for (const auto& transition : _transitions)
     {
-        fillError(_error, ErrorCode::FairMQChangeStateFailed, toString("Unexpected FairMQ transition ", _transition));
-        return false;
+        auto it{ expectedState.find(transition) };
+        if (it == expectedState.end() || it->second == DeviceState::Undefined)
+        {
+            fillError(
+                _error, ErrorCode::FairMQChangeStateFailed, toString("Unexpected FairMQ transition ", transition));
+            return false;
+        }
+        transitionsStr << (transitionsStr.tellp() > 0 ? ", " : "") << transition;
     }
+    // the state summary compares against the final state of the sequence
+    DeviceState _expectedState{ expectedState.at(_transitions.back()) };
+
+    // every transition keeps the time budget it had as a separate request, unless its history allows less
+    chrono::milliseconds const maxTimeout{ m_timeout * static_cast<chrono::seconds::rep>(_transitions.size()) };
+    auto const timeout{ info->m_transitionHistory.timeout(transitionsStr.str(), _path, maxTimeout) };
+    bool const adaptive{ timeout < maxTimeout };
+    STimeMeasure<chrono::milliseconds> measure;
 
     bool success(true);
 
     try
     {
         std::condition_variable cv;
+        std::mutex mtx;
+        // guarded by mtx, the handler may already run inside the initiating call, before the wait has started
+        bool done{ false };
 
-        info->m_fairmqTopology->AsyncChangeState(
-            _transition,
-            _path,
-            m_timeout,
-            [&cv, &success, &_aggregatedState, &_topologyState, &_error, &info, &_expectedState, this](
+        auto onCompletion{
+            [&cv, &mtx, &done, &success, &_aggregatedState, &_topologyState, &_error, &info, &_expectedState, this](
                 std::error_code _ec, FairMQTopologyState _state)
             {
+                std::lock_guard<std::mutex> lock(mtx);
+                done = true;
                 success = !_ec;
                 if (success)
                 {
@@ -761,7 +819,8 @@ bool CControlService::SImpl::changeState(const partitionID_t& _partitionID,
                         fillError(_error,
                                   ErrorCode::FairMQChangeStateFailed,
                                   string("Aggregate topology state failed: ") + _e.what());
-                        OLOG(ESeverity::error) << stateSummaryString(_state, _expectedState, info->m_topo);
+                        OLOG(ESeverity::error)
+                            << stateSummaryString(info->m_fairmqTopology, _expectedState, info->m_topo);
                     }
                     if (_topologyState != nullptr)
                         fairMQToODCTopologyState(info->m_topo, _state, _topologyState);
@@ -771,36 +830,78 @@ bool CControlService::SImpl::changeState(const partitionID_t& _partitionID,
                     fillError(_error,
                               ErrorCode::FairMQChangeStateFailed,
                               string("FairMQ change state failed: ") + _ec.message());
-                    OLOG(ESeverity::error) << stateSummaryString(_state, _expectedState, info->m_topo);
+                    OLOG(ESeverity::error)
+                        << stateSummaryString(info->m_fairmqTopology, _expectedState, info->m_topo);
                 }
                 cv.notify_all();
-            });
+            }
+        };
 
-        std::mutex mtx;
-        std::unique_lock<std::mutex> lock(mtx);
-        std::cv_status waitStatus = cv.wait_for(lock, m_timeout);
+        // latencies of this very request, other requests may complete concurrently on the same topology
+        auto stats{ make_shared<TransitionLatencyStats>() };
+        ProgressOptions progress;
+        progress.latencyHandler = [stats](const TransitionLatencyStats& _stats) { *stats = _stats; };
 
-        if (waitStatus == std::cv_status::timeout)
+        if (m_deviceWalk && _transitions.size() > 1)
+        {
+            // devices walk to the final state on their own, saves a controller round trip per step and device.
+            // Plugins without change_state_to support ignore the command, hence only on request.
+            info->m_fairmqTopology->AsyncChangeStateTo(_expectedState, _path, timeout, progress, onCompletion);
+        }
+        else
+        {
+            info->m_fairmqTopology->AsyncChangeStateSequence(_transitions, _path, timeout, progress, onCompletion);
+        }
+
+        std::unique_lock<std::mutex> lock(mtx);
+        if (!cv.wait_for(lock, timeout, [&done] { return done; }))
         {
             success = false;
-            string msg{ toString("Timed out waiting for change state ", _transition) };
+            string msg{ toString("Timed out waiting for change state ", transitionsStr.str()) };
+            if (adaptive)
+            {
+                msg += toString(" (adaptive timeout of ", timeout.count(), " ms)");
+            }
             fillError(_error, ErrorCode::RequestTimeout, msg);
             OLOG(ESeverity::error) << msg << endl
-                                   << stateSummaryString(
-                                          info->m_fairmqTopology->GetCurrentState(), _expectedState, info->m_topo);
+                                   << stateSummaryString(info->m_fairmqTopology, _expectedState, info->m_topo);
         }
         else
         {
-            OLOG(ESeverity::info) << "Changed state to " << _aggregatedState << " via " << _transition
+            OLOG(ESeverity::info) << "Changed state to " << _aggregatedState << " via " << transitionsStr.str()
                                   << " transition for partition " << std::quoted(_partitionID);
+            if (success)
+            {
+                info->m_transitionHistory.record(
+                    transitionsStr.str(), _path, chrono::milliseconds(measure.duration()));
+            }
+            stringstream slowest;
+            for (size_t i = 0; i < min<size_t>(3, stats->slowest.size()); ++i)
+            {
+                slowest << (i > 0 ? ", " : "") << stats->slowest[i].taskId << " ("
+                        << stats->slowest[i].latency.count() << " us)";
+            }
+            OLOG(ESeverity::debug) << "Transition latencies of " << stats->reached << " devices: p50 "
+                                   << stats->p50.count() << " us, p95 " << stats->p95.count() << " us, p99 "
+                                   << stats->p99.count() << " us, max " << stats->max.count()
+                                   << " us; slowest: " << slowest.str();
+            if (_transitionStats != nullptr)
+            {
+                *_transitionStats = *stats;
+            }
         }
     }
     catch (exception& _e)
     {
         success = false;
         fillError(_error, ErrorCode::FairMQChangeStateFailed, string("Change state failed: ") + _e.what());
-        OLOG(ESeverity::error) << stateSummaryString(
-            info->m_fairmqTopology->GetCurrentState(), _expectedState, info->m_topo);
+        OLOG(ESeverity::error) << stateSummaryString(info->m_fairmqTopology, _expectedState, info->m_topo);
+    }
+
+    if (!success && adaptive)
+    {
+        // the deadline may have been too tight, the next attempt gets the full configured timeout
+        info->m_transitionHistory.forget(transitionsStr.str(), _path);
     }
 
     return success;
@@ -810,24 +911,37 @@ bool CControlService::SImpl::changeStateConfigure(const partitionID_t& _partitio
                                                   SError& _error,
                                                   const string& _path,
                                                   AggregatedTopologyState& _aggregatedState,
-                                                  TopologyState* _topologyState)
+                                                  TopologyState* _topologyState,
+                                                  TransitionLatencyStats* _transitionStats)
 {
-    return changeState(_partitionID, _error, TopologyTransition::InitDevice, _path, _aggregatedState, _topologyState) &&
-           changeState(
-               _partitionID, _error, TopologyTransition::CompleteInit, _path, _aggregatedState, _topologyState) &&
-           changeState(_partitionID, _error, TopologyTransition::Bind, _path, _aggregatedState, _topologyState) &&
-           changeState(_partitionID, _error, TopologyTransition::Connect, _path, _aggregatedState, _topologyState) &&
-           changeState(_partitionID, _error, TopologyTransition::InitTask, _path, _aggregatedState, _topologyState);
+    // devices advance through the sequence independently, no barrier between the transitions
+    return changeStateSequence(_partitionID,
+                               _error,
+                               { TopologyTransition::InitDevice,
+                                 TopologyTransition::CompleteInit,
+                                 TopologyTransition::Bind,
+                                 TopologyTransition::Connect,
+                                 TopologyTransition::InitTask },
+                               _path,
+                               _aggregatedState,
+                               _topologyState,
+                               _transitionStats);
 }
 
 bool CControlService::SImpl::changeStateReset(const partitionID_t& _partitionID,
                                               SError& _error,
                                               const string& _path,
                                               AggregatedTopologyState& _aggregatedState,
-                                              TopologyState* _topologyState)
+                                              TopologyState* _topologyState,
+                                              TransitionLatencyStats* _transitionStats)
 {
-    return changeState(_partitionID, _error, TopologyTransition::ResetTask, _path, _aggregatedState, _topologyState) &&
-           changeState(_partitionID, _error, TopologyTransition::ResetDevice, _path, _aggregatedState, _topologyState);
+    return changeStateSequence(_partitionID,
+                               _error,
+                               { TopologyTransition::ResetTask, TopologyTransition::ResetDevice },
+                               _path,
+                               _aggregatedState,
+                               _topologyState,
+                               _transitionStats);
 }
 
 bool CControlService::SImpl::getState(const partitionID_t& _partitionID,
@@ -844,11 +958,10 @@ bool CControlService::SImpl::getState(const partitionID_t& _partitionID,
     }
 
     bool success(true);
-    auto const state(info->m_fairmqTopology->GetCurrentState());
 
     try
     {
-        _aggregatedState = aggregateStateForPath(info->m_topo, state, _path);
+        _aggregatedState = aggregateStateForPath(info->m_fairmqTopology, _path);
     }
     catch (exception& _e)
     {
@@ -856,7 +969,7 @@ bool CControlService::SImpl::getState(const partitionID_t& _partitionID,
         fillError(_error, ErrorCode::FairMQGetStateFailed, string("Get state failed: ") + _e.what());
     }
     if (_topologyState != nullptr)
-        fairMQToODCTopologyState(info->m_topo, state, _topologyState);
+        fairMQToODCTopologyState(info->m_topo, info->m_fairmqTopology->GetStateSnapshot()->state, _topologyState);
 
     return success;
 }
@@ -921,65 +1034,15 @@ bool CControlService::SImpl::setProperties(const partitionID_t& _partitionID,
     return success;
 }
 
-AggregatedTopologyState CControlService::SImpl::aggregateStateForPath(const DDSTopologyPtr_t& _topo,
-                                                                      const FairMQTopologyState& _topoState,
+AggregatedTopologyState CControlService::SImpl::aggregateStateForPath(const FairMQTopologyPtr_t& _topo,
                                                                       const string& _path)
 {
-    if (_path.empty())
-        return AggregateState(_topoState);
-
     if (_topo == nullptr)
-        throw runtime_error("DDS topology is not initialized");
+        throw runtime_error("FairMQ topology is not initialized");
 
-    try
-    {
-        // Check if path points to a single task
-        // If task is found than return it's state as an aggregated topology state
-
-        // Throws if task not found for path
-        const auto& task{ _topo->getRuntimeTask(_path) };
-        auto it{ find_if(_topoState.cbegin(),
-                         _topoState.cend(),
-                         [&](const FairMQTopologyState::value_type& _v) { return _v.taskId == task.m_taskId; }) };
-        if (it != _topoState.cend())
-            return static_cast<AggregatedTopologyState>(it->state);
-
-        throw runtime_error("Device not found for path " + _path);
-    }
-    catch (exception& _e)
-    {
-        // In case of exception check that path contains multiple tasks
-
-        // Collect all task IDs to a set for fast search
-        set<Id_t> taskIds;
-        auto it{ _topo->getRuntimeTaskIteratorMatchingPath(_path) };
-        for_each(it.first,
-                 it.second,
-                 [&](const STopoRuntimeTask::FilterIterator_t::value_type& _v) { taskIds.insert(_v.second.m_taskId); });
-
-        if (taskIds.empty())
-            throw runtime_error("No tasks found matching the path " + _path);
-
-        // Find a state of a first task
-        auto firstIt{ find_if(_topoState.cbegin(),
-                              _topoState.cend(),
-                              [&](const FairMQTopologyState::value_type& _v)
-                              { return _v.taskId == *(taskIds.begin()); }) };
-        if (firstIt == _topoState.cend())
-            throw runtime_error("No states found for path " + _path);
-
-        // Check that all selected devices have the same state
-        AggregatedTopologyState first{ static_cast<AggregatedTopologyState>(firstIt->state) };
-        if (std::all_of(_topoState.cbegin(),
-                        _topoState.cend(),
-                        [&](const FairMQTopologyState::value_type& _v)
-                        { return (taskIds.count(_v.taskId) > 0) ? _v.state == first : true; }))
-        {
-            return first;
-        }
-
-        return AggregatedTopologyState::Mixed;
-    }
+    // Path selections are resolved once and cached by the topology; a path pointing to a single task yields the state
+    // of that task, otherwise the states of all tasks matching the path are aggregated. Throws if no task matches.
+    return _topo->AggregateState(_path);
 }
 
 void CControlService::SImpl::fairMQToODCTopologyState(const DDSTopologyPtr_t& _topo,
@@ -1030,19 +1093,16 @@ SError CControlService::SImpl::checkSessionIsRunning(const partitionID_t& _parti
     return error;
 }
 
-string CControlService::SImpl::stateSummaryString(const FairMQTopologyState& _topologyState,
+string CControlService::SImpl::stateSummaryString(const FairMQTopologyPtr_t& _fairmqTopology,
                                                   DeviceState _expectedState,
                                                   DDSTopologyPtr_t _topo)
 {
-    size_t totalCount{ _topologyState.size() };
+    size_t totalCount{ _fairmqTopology->GetNumDevices() };
     size_t failedCount{ 0 };
     stringstream ss;
-    for (const auto& status : _topologyState)
+    // Print only failed devices, selected by a vectorized scan over the device states
+    for (const auto& status : _fairmqTopology->GetDevicesNotInState(_expectedState))
     {
-        // Print only failed devices
-        if (status.state == _expectedState)
-            continue;
-
         failedCount++;
         if (failedCount == 1)
         {
@@ -1184,6 +1244,11 @@ void CControlService::setTimeout(const chrono::seconds& _timeout)
     m_impl->setTimeout(_timeout);
 }
 
+void CControlService::setDeviceWalk(bool _deviceWalk)
+{
+    m_impl->setDeviceWalk(_deviceWalk);
+}
+
 void CControlService::registerResourcePlugins(const CDDSSubmit::PluginMap_t& _pluginMap)
 {
     m_impl->registerResourcePlugins(_pluginMap);
@@ -133,7 +133,8 @@ namespace odc::core
         {
         }
 
-        TopologyState m_topologyState; ///< FairMQ aggregated topology state
+        TopologyState m_topologyState;           ///< FairMQ aggregated topology state
+        TransitionLatencyStats m_transitionStats; ///< Device latencies of the transition, for change state requests
     };
 
     /// \brief Structure holds return value of the request
@@ -317,6 +318,11 @@ namespace odc::core
         /// \param [in] _timeout Timeout in seconds
         void setTimeout(const std::chrono::seconds& _timeout);
 
+        /// \brief Let devices walk multi-transition requests to the target state on their own
+        /// \param [in] _deviceWalk Requires the ODC plugin of all devices to support the change_state_to command.
+        /// If false (default), the controller sends every transition of the sequence to every device.
+        void setDeviceWalk(bool _deviceWalk);
+
         /// \brief Register resource plugins
         /// \param [in] _pluginMap Map of plugin name to path
         void registerResourcePlugins(const CDDSSubmit::PluginMap_t& _pluginMap);
@@ -35,6 +35,10 @@ namespace odc::core
                 return "failed to get FairMQ device properties";
             case ErrorCode::DeviceSetPropertiesFailed:
                 return "failed to set FairMQ device properties";
+            case ErrorCode::DeviceFailed:
+                return "FairMQ device crashed or entered Error state";
+            case ErrorCode::DevicesExcluded:
+                return "async operation completed without failed FairMQ devices";
             case ErrorCode::DDSCreateSessionFailed:
                 return "Failed to create a DDS session";
             case ErrorCode::DDSShutdownSessionFailed:
@@ -33,6 +33,8 @@ namespace odc::core
         DeviceChangeStateFailed,
         DeviceGetPropertiesFailed,
         DeviceSetPropertiesFailed,
+        DeviceFailed,
+        DevicesExcluded,
 
         DDSCreateSessionFailed = 200,
         DDSShutdownSessionFailed,
@@ -0,0 +1,102 @@
+// Copyright 2019 GSI, Inc. All rights reserved.
+//
+// Duration history of change state requests, from which their timeouts are derived.
+//
+#ifndef __ODC__TransitionHistory__
+#define __ODC__TransitionHistory__
+
+// STD
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace odc::core
+{
+    /// \brief Durations of the latest successful change state requests of a session
+    ///
+    /// The durations are kept per transition sequence and topology path, a request scoped to a few devices says
+    /// little about the duration of the same transitions on the whole topology.
+    class CTransitionHistory
+    {
+      public:
+        struct SConfig
+        {
+            size_t m_historySize{ 20 };                     ///< Durations kept per transition sequence and path
+            size_t m_minSamples{ 5 };                       ///< Durations needed before adapting the timeout
+            double m_factor{ 3.0 };                         ///< Safety factor applied to the p99 duration
+            std::chrono::milliseconds m_minTimeout{ 5000 }; ///< Lower bound of adaptive timeouts
+        };
+
+        CTransitionHistory() = default;
+
+        explicit CTransitionHistory(const SConfig& _config)
+            : m_config(_config)
+        {
+            // an empty history never yields a p99
+            m_config.m_minSamples = std::max(m_config.m_minSamples, size_t(1));
+        }
+
+        /// \brief Timeout of the next request
+        /// \param [in] _transitions Transition sequence of the request
+        /// \param [in] _path Topology path the request is scoped to
+        /// \param [in] _timeout Configured timeout, returned as long as there are too few samples
+        /// \return Safety factor times the p99 of the recorded durations, within [m_minTimeout, _timeout]
+        std::chrono::milliseconds timeout(const std::string& _transitions,
+                                          const std::string& _path,
+                                          std::chrono::milliseconds _timeout) const
+        {
+            std::vector<std::chrono::milliseconds> durations;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto it{ m_durations.find(Key_t(_transitions, _path)) };
+                if (it == m_durations.end() || it->second.size() < m_config.m_minSamples)
+                {
+                    return _timeout;
+                }
+                durations.assign(it->second.begin(), it->second.end());
+            }
+
+            // nearest rank
+            std::sort(durations.begin(), durations.end());
+            size_t const rank{ static_cast<size_t>(std::ceil(0.99 * durations.size())) };
+            auto const p99{ durations[std::max(rank, size_t(1)) - 1] };
+            auto const adaptive{ std::chrono::milliseconds(
+                static_cast<std::chrono::milliseconds::rep>(m_config.m_factor * p99.count())) };
+            return std::min(_timeout, std::max(adaptive, m_config.m_minTimeout));
+        }
+
+        /// \brief Record the duration of a successful request, dropping the oldest one beyond m_historySize
+        void record(const std::string& _transitions, const std::string& _path, std::chrono::milliseconds _duration)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto& durations{ m_durations[Key_t(_transitions, _path)] };
+            durations.push_back(_duration);
+            while (durations.size() > m_config.m_historySize)
+            {
+                durations.pop_front();
+            }
+        }
+
+        /// \brief Drop the durations of the transitions on the path, the next request gets the configured timeout
+        void forget(const std::string& _transitions, const std::string& _path)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_durations.erase(Key_t(_transitions, _path));
+        }
+
+      private:
+        using Key_t = std::pair<std::string, std::string>; ///< transitions, path
+
+        SConfig m_config;
+        std::map<Key_t, std::deque<std::chrono::milliseconds>> m_durations; ///< oldest first
+        mutable std::mutex m_mutex;                                          ///< Guards m_durations
+    };
+} // namespace odc::core
+
+#endif /* __ODC__TransitionHistory__ */
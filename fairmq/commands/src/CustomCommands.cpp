@@ -13,6 +13,9 @@
 #include <flatbuffers/idl.h>
 
 #include <array>
+#include <map>
+#include <mutex>
+#include <optional>
 
 using namespace std;
 
@@ -25,7 +28,7 @@ namespace odc::cc
 
     array<string, 2> resultNames = { { "Ok", "Failure" } };
 
-    array<string, 17> typeNames = { { "CheckState",
+    array<string, 19> typeNames = { { "CheckState",
                                       "ChangeState",
                                       "DumpConfig",
                                       "SubscribeToStateChange",
@@ -34,6 +37,7 @@ namespace odc::cc
                                       "GetProperties",
                                       "SetProperties",
                                       "SubscriptionHeartbeat",
+                                      "ChangeStateTo",
 
                                       "CurrentState",
                                       "TransitionStatus",
@@ -42,7 +46,8 @@ namespace odc::cc
                                       "StateChangeUnsubscription",
                                       "StateChange",
                                       "Properties",
-                                      "PropertiesSet" } };
+                                      "PropertiesSet",
+                                      "StateChangeBatch" } };
 
     array<fair::mq::State, 16> fbStateToMQState = { { fair::mq::State::Undefined,
                                                       fair::mq::State::Ok,
@@ -104,7 +109,7 @@ namespace odc::cc
                                                              FBTransition_End,
                                                              FBTransition_ErrorFound } };
 
-    array<FBCmd, 17> typeToFBCmd = { { FBCmd::FBCmd_check_state,
+    array<FBCmd, 19> typeToFBCmd = { { FBCmd::FBCmd_check_state,
                                        FBCmd::FBCmd_change_state,
                                        FBCmd::FBCmd_dump_config,
                                        FBCmd::FBCmd_subscribe_to_state_change,
@@ -113,6 +118,7 @@ namespace odc::cc
                                        FBCmd::FBCmd_get_properties,
                                        FBCmd::FBCmd_set_properties,
                                        FBCmd::FBCmd_subscription_heartbeat,
+                                       FBCmd::FBCmd_change_state_to,
                                        FBCmd::FBCmd_current_state,
                                        FBCmd::FBCmd_transition_status,
                                        FBCmd::FBCmd_config,
@@ -120,9 +126,10 @@ namespace odc::cc
                                        FBCmd::FBCmd_state_change_unsubscription,
                                        FBCmd::FBCmd_state_change,
                                        FBCmd::FBCmd_properties,
-                                       FBCmd::FBCmd_properties_set } };
+                                       FBCmd::FBCmd_properties_set,
+                                       FBCmd::FBCmd_state_change_batch } };
 
-    array<Type, 17> fbCmdToType = { { Type::check_state,
+    array<Type, 19> fbCmdToType = { { Type::check_state,
                                       Type::change_state,
                                       Type::dump_config,
                                       Type::subscribe_to_state_change,
@@ -138,7 +145,9 @@ namespace odc::cc
                                       Type::state_change_unsubscription,
                                       Type::state_change,
                                       Type::properties,
-                                      Type::properties_set } };
+                                      Type::properties_set,
+                                      Type::change_state_to,
+                                      Type::state_change_batch } };
 
     fair::mq::State GetMQState(const FBState state)
     {
@@ -179,65 +188,127 @@ namespace odc::cc
         return typeToFBCmd.at(static_cast<int>(type));
     }
 
+    namespace
+    {
+        /// Serialization state reused by all Serialize() calls on a thread, keeps its memory in between
+        struct SerializationArena
+        {
+            flatbuffers::FlatBufferBuilder fbb{ 1024 };
+            vector<flatbuffers::Offset<FBCommand>> commandOffsets;
+            vector<FBStateChangeEntry> stateChanges;
+        };
+        /// the buffer of a larger message, e.g. a big property dump, is released on the next use
+        constexpr size_t maxRetainedArenaSize = 64 * 1024;
+
+        SerializationArena& GetSerializationArena()
+        {
+            thread_local SerializationArena arena;
+            if (arena.fbb.GetSize() > maxRetainedArenaSize)
+            {
+                arena.fbb = flatbuffers::FlatBufferBuilder(1024);
+            }
+            arena.fbb.Clear();
+            arena.commandOffsets.clear();
+            return arena;
+        }
+
+        unique_ptr<flatbuffers::Parser> MakeSchemaParser()
+        {
+            auto parser = make_unique<flatbuffers::Parser>();
+            if (!parser->Parse(customCommandsFormatDefFbs))
+            {
+                throw Cmds::CommandFormatError("couldn't parse commands format: " + parser->error_);
+            }
+            return parser;
+        }
+
+        /// Schema for JSON output, parsed once. GenerateText() only reads the parser, it is shared by all threads.
+        const flatbuffers::Parser& GetSchemaParser()
+        {
+            static unique_ptr<const flatbuffers::Parser> const parser(MakeSchemaParser());
+            return *parser;
+        }
+
+        /// JSON input is parsed into the builder of the parser, which therefore can only be reused on one thread.
+        /// Dropped after an error or a large message, the schema is parsed again on the next use.
+        thread_local unique_ptr<flatbuffers::Parser> jsonParser;
+
+        flatbuffers::Parser& GetJSONParser()
+        {
+            if (jsonParser && jsonParser->builder_.GetSize() > maxRetainedArenaSize)
+            {
+                jsonParser.reset();
+            }
+            if (!jsonParser)
+            {
+                jsonParser = MakeSchemaParser();
+            }
+            jsonParser->builder_.Clear();
+            return *jsonParser;
+        }
+    } // namespace
+
     string Cmds::Serialize(const Format type) const
     {
-        flatbuffers::FlatBufferBuilder fbb;
-        vector<flatbuffers::Offset<FBCommand>> commandOffsets;
+        auto& arena = GetSerializationArena();
+        auto& fbb = arena.fbb;
+        auto& commandOffsets = arena.commandOffsets;
+        auto& stateChanges = arena.stateChanges;
 
         for (auto& cmd : fCmds)
         {
             flatbuffers::Offset<FBCommand> cmdOffset;
-            unique_ptr<FBCommandBuilder> cmdBuilder; // delay the creation of the builder, because child strings need to
-                                                     // be constructed first (which are conditional)
+            optional<FBCommandBuilder> cmdBuilder; // delay the creation of the builder, because child strings need to
+                                                   // be constructed first (which are conditional)
 
             switch (cmd->GetType())
             {
                 case Type::check_state:
                 {
-                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    cmdBuilder.emplace(fbb);
                 }
                 break;
                 case Type::change_state:
                 {
-                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    cmdBuilder.emplace(fbb);
                     cmdBuilder->add_transition(GetFBTransition(static_cast<ChangeState&>(*cmd).GetTransition()));
                 }
                 break;
                 case Type::dump_config:
                 {
-                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    cmdBuilder.emplace(fbb);
                 }
                 break;
                     break;
                 case Type::subscribe_to_state_change:
                 {
-                    auto _cmd = static_cast<SubscribeToStateChange&>(*cmd);
-                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    auto const& _cmd = static_cast<const SubscribeToStateChange&>(*cmd);
+                    cmdBuilder.emplace(fbb);
                     cmdBuilder->add_interval(_cmd.GetInterval());
                 }
                 break;
                 case Type::unsubscribe_from_state_change:
                 {
-                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    cmdBuilder.emplace(fbb);
                 }
                 break;
                 case Type::state_change_exiting_received:
                 {
-                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    cmdBuilder.emplace(fbb);
                 }
                 break;
                 case Type::get_properties:
                 {
-                    auto _cmd = static_cast<GetProperties&>(*cmd);
+                    auto const& _cmd = static_cast<const GetProperties&>(*cmd);
                     auto query = fbb.CreateString(_cmd.GetQuery());
-                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    cmdBuilder.emplace(fbb);
                     cmdBuilder->add_request_id(_cmd.GetRequestId());
                     cmdBuilder->add_property_query(query);
                 }
                 break;
                 case Type::set_properties:
                 {
-                    auto _cmd = static_cast<SetProperties&>(*cmd);
+                    auto const& _cmd = static_cast<const SetProperties&>(*cmd);
                     std::vector<flatbuffers::Offset<FBProperty>> propsVector;
                     for (auto const& e : _cmd.GetProps())
                     {
@@ -246,32 +317,38 @@ namespace odc::cc
                         propsVector.push_back(CreateFBProperty(fbb, key, val));
                     }
                     auto props = fbb.CreateVector(propsVector);
-                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    cmdBuilder.emplace(fbb);
                     cmdBuilder->add_request_id(_cmd.GetRequestId());
                     cmdBuilder->add_properties(props);
                 }
                 break;
                 case Type::subscription_heartbeat:
                 {
-                    auto _cmd = static_cast<SubscriptionHeartbeat&>(*cmd);
-                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    auto const& _cmd = static_cast<const SubscriptionHeartbeat&>(*cmd);
+                    cmdBuilder.emplace(fbb);
                     cmdBuilder->add_interval(_cmd.GetInterval());
                 }
                 break;
+                case Type::change_state_to:
+                {
+                    cmdBuilder.emplace(fbb);
+                    cmdBuilder->add_state(GetFBState(static_cast<ChangeStateTo&>(*cmd).GetTargetState()));
+                }
+                break;
                 case Type::current_state:
                 {
-                    auto _cmd = static_cast<CurrentState&>(*cmd);
+                    auto const& _cmd = static_cast<const CurrentState&>(*cmd);
                     auto deviceId = fbb.CreateString(_cmd.GetDeviceId());
-                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    cmdBuilder.emplace(fbb);
                     cmdBuilder->add_device_id(deviceId);
                     cmdBuilder->add_current_state(GetFBState(_cmd.GetCurrentState()));
                 }
                 break;
                 case Type::transition_status:
                 {
-                    auto _cmd = static_cast<TransitionStatus&>(*cmd);
+                    auto const& _cmd = static_cast<const TransitionStatus&>(*cmd);
                     auto deviceId = fbb.CreateString(_cmd.GetDeviceId());
-                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    cmdBuilder.emplace(fbb);
                     cmdBuilder->add_device_id(deviceId);
                     cmdBuilder->add_task_id(_cmd.GetTaskId());
                     cmdBuilder->add_result(GetFBResult(_cmd.GetResult()));
@@ -281,19 +358,19 @@ namespace odc::cc
                 break;
                 case Type::config:
                 {
-                    auto _cmd = static_cast<Config&>(*cmd);
+                    auto const& _cmd = static_cast<const Config&>(*cmd);
                     auto deviceId = fbb.CreateString(_cmd.GetDeviceId());
                     auto config = fbb.CreateString(_cmd.GetConfig());
-                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    cmdBuilder.emplace(fbb);
                     cmdBuilder->add_device_id(deviceId);
                     cmdBuilder->add_config_string(config);
                 }
                 break;
                 case Type::state_change_subscription:
                 {
-                    auto _cmd = static_cast<StateChangeSubscription&>(*cmd);
+                    auto const& _cmd = static_cast<const StateChangeSubscription&>(*cmd);
                     auto deviceId = fbb.CreateString(_cmd.GetDeviceId());
-                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    cmdBuilder.emplace(fbb);
                     cmdBuilder->add_device_id(deviceId);
                     cmdBuilder->add_task_id(_cmd.GetTaskId());
                     cmdBuilder->add_result(GetFBResult(_cmd.GetResult()));
@@ -301,9 +378,9 @@ namespace odc::cc
                 break;
                 case Type::state_change_unsubscription:
                 {
-                    auto _cmd = static_cast<StateChangeUnsubscription&>(*cmd);
+                    auto const& _cmd = static_cast<const StateChangeUnsubscription&>(*cmd);
                     auto deviceId = fbb.CreateString(_cmd.GetDeviceId());
-                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    cmdBuilder.emplace(fbb);
                     cmdBuilder->add_device_id(deviceId);
                     cmdBuilder->add_task_id(_cmd.GetTaskId());
                     cmdBuilder->add_result(GetFBResult(_cmd.GetResult()));
@@ -311,9 +388,9 @@ namespace odc::cc
                 break;
                 case Type::state_change:
                 {
-                    auto _cmd = static_cast<StateChange&>(*cmd);
+                    auto const& _cmd = static_cast<const StateChange&>(*cmd);
                     auto deviceId = fbb.CreateString(_cmd.GetDeviceId());
-                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    cmdBuilder.emplace(fbb);
                     cmdBuilder->add_device_id(deviceId);
                     cmdBuilder->add_task_id(_cmd.GetTaskId());
                     cmdBuilder->add_last_state(GetFBState(_cmd.GetLastState()));
@@ -322,7 +399,7 @@ namespace odc::cc
                 break;
                 case Type::properties:
                 {
-                    auto _cmd = static_cast<Properties&>(*cmd);
+                    auto const& _cmd = static_cast<const Properties&>(*cmd);
                     auto deviceId = fbb.CreateString(_cmd.GetDeviceId());
 
                     std::vector<flatbuffers::Offset<FBProperty>> propsVector;
@@ -334,7 +411,7 @@ namespace odc::cc
                         propsVector.push_back(prop);
                     }
                     auto props = fbb.CreateVector(propsVector);
-                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    cmdBuilder.emplace(fbb);
                     cmdBuilder->add_device_id(deviceId);
                     cmdBuilder->add_request_id(_cmd.GetRequestId());
                     cmdBuilder->add_result(GetFBResult(_cmd.GetResult()));
@@ -343,14 +420,28 @@ namespace odc::cc
                 break;
                 case Type::properties_set:
                 {
-                    auto _cmd = static_cast<PropertiesSet&>(*cmd);
+                    auto const& _cmd = static_cast<const PropertiesSet&>(*cmd);
                     auto deviceId = fbb.CreateString(_cmd.GetDeviceId());
-                    cmdBuilder = make_unique<FBCommandBuilder>(fbb);
+                    cmdBuilder.emplace(fbb);
                     cmdBuilder->add_device_id(deviceId);
                     cmdBuilder->add_request_id(_cmd.GetRequestId());
                     cmdBuilder->add_result(GetFBResult(_cmd.GetResult()));
                 }
                 break;
+                case Type::state_change_batch:
+                {
+                    auto const& _cmd = static_cast<const StateChangeBatch&>(*cmd);
+                    stateChanges.clear();
+                    for (auto const& e : _cmd.GetStateChanges())
+                    {
+                        stateChanges.emplace_back(
+                            e.taskId, e.timestamp, GetFBState(e.lastState), GetFBState(e.currentState));
+                    }
+                    auto entries = fbb.CreateVectorOfStructs(stateChanges);
+                    cmdBuilder.emplace(fbb);
+                    cmdBuilder->add_state_changes(entries);
+                }
+                break;
                 default:
                     throw CommandFormatError("unrecognized command type given to odc::cc::Cmds::Serialize()");
                     break;
@@ -372,13 +463,8 @@ namespace odc::cc
         }
         else
         { // Type == Format::JSON
-            flatbuffers::Parser parser;
-            if (!parser.Parse(customCommandsFormatDefFbs))
-            {
-                throw CommandFormatError("Serialize couldn't parse commands format");
-            }
             std::string json;
-            if (!flatbuffers::GenerateText(parser, fbb.GetBufferPointer(), &json))
+            if (!flatbuffers::GenerateText(GetSchemaParser(), fbb.GetBufferPointer(), &json))
             {
                 throw CommandFormatError("Serialize couldn't serialize parsed data to JSON!");
             }
@@ -386,119 +472,267 @@ namespace odc::cc
         }
     }
 
+    namespace
+    {
+        /// Pre-encoded single commands by type and argument, the map is node based and never erases
+        struct EncodedCmdCache
+        {
+            mutex mtx;
+            map<pair<Type, int64_t>, const string> buffers;
+        };
+
+        const string& GetEncoded(Type type, int64_t arg, unique_ptr<Cmd> (*makeCmd)(int64_t))
+        {
+            static EncodedCmdCache cache;
+            lock_guard<mutex> lk(cache.mtx);
+            auto it = cache.buffers.find({ type, arg });
+            if (it == cache.buffers.end())
+            {
+                it = cache.buffers.emplace(make_pair(type, arg), Cmds(makeCmd(arg)).Serialize()).first;
+            }
+            return it->second;
+        }
+    } // namespace
+
+    const string& EncodedCmds::ChangeState(const fair::mq::Transition transition)
+    {
+        return GetEncoded(Type::change_state,
+                          static_cast<int64_t>(transition),
+                          [](int64_t arg) { return make<cc::ChangeState>(static_cast<fair::mq::Transition>(arg)); });
+    }
+    const string& EncodedCmds::ChangeStateTo(const fair::mq::State state)
+    {
+        return GetEncoded(Type::change_state_to,
+                          static_cast<int64_t>(state),
+                          [](int64_t arg) { return make<cc::ChangeStateTo>(static_cast<fair::mq::State>(arg)); });
+    }
+    const string& EncodedCmds::StateChangeExitingReceived()
+    {
+        return GetEncoded(
+            Type::state_change_exiting_received, 0, [](int64_t) { return make<cc::StateChangeExitingReceived>(); });
+    }
+    const string& EncodedCmds::SubscribeToStateChange(const int64_t interval)
+    {
+        return GetEncoded(Type::subscribe_to_state_change,
+                          interval,
+                          [](int64_t arg) { return make<cc::SubscribeToStateChange>(arg); });
+    }
+    const string& EncodedCmds::SubscriptionHeartbeat(const int64_t interval)
+    {
+        return GetEncoded(
+            Type::subscription_heartbeat, interval, [](int64_t arg) { return make<cc::SubscriptionHeartbeat>(arg); });
+    }
+    const string& EncodedCmds::UnsubscribeFromStateChange()
+    {
+        return GetEncoded(Type::unsubscribe_from_state_change,
+                          0,
+                          [](int64_t) { return make<cc::UnsubscribeFromStateChange>(); });
+    }
+
     void Cmds::Deserialize(const string& str, const Format type)
     {
         fCmds.clear();
 
-        const flatbuffers::Vector<flatbuffers::Offset<FBCommand>>* cmds = nullptr;
-
-        flatbuffers::Parser parser;
         if (type == Format::Binary)
         {
-            cmds = GetFBCommands(const_cast<char*>(str.c_str()))->commands();
+            for (const auto cmd : CmdsView(str))
+            {
+                fCmds.emplace_back(cmd.ToCmd());
+            }
         }
         else
         { // Type == Format::JSON
-            if (!parser.Parse(customCommandsFormatDefFbs))
-            {
-                throw CommandFormatError("Deserialize couldn't parse commands format");
-            }
+            auto& parser = GetJSONParser();
             if (!parser.Parse(str.c_str()))
             {
+                jsonParser.reset();
                 throw CommandFormatError("Deserialize couldn't parse incoming JSON string");
             }
-            cmds = GetFBCommands(parser.builder_.GetBufferPointer())->commands();
+            string_view const buffer(reinterpret_cast<const char*>(parser.builder_.GetBufferPointer()),
+                                     parser.builder_.GetSize());
+            for (const auto cmd : CmdsView(buffer))
+            {
+                fCmds.emplace_back(cmd.ToCmd());
+            }
+        }
+    }
+
+    namespace
+    {
+        const FBCommand& AsFBCommand(const void* cmd)
+        {
+            return *static_cast<const FBCommand*>(cmd);
+        }
+
+        string_view AsStringView(const flatbuffers::String* str)
+        {
+            return str == nullptr ? string_view() : string_view(str->c_str(), str->size());
+        }
+    } // namespace
+
+    Type CmdView::GetType() const
+    {
+        auto const id = static_cast<size_t>(AsFBCommand(fCmd).command_id());
+        if (id >= fbCmdToType.size())
+        {
+            throw Cmds::CommandFormatError("unrecognized command type given to odc::cc::CmdView::GetType()");
         }
+        return fbCmdToType[id];
+    }
+    string_view CmdView::GetDeviceId() const
+    {
+        return AsStringView(AsFBCommand(fCmd).device_id());
+    }
+    uint64_t CmdView::GetTaskId() const
+    {
+        return AsFBCommand(fCmd).task_id();
+    }
+    size_t CmdView::GetRequestId() const
+    {
+        return AsFBCommand(fCmd).request_id();
+    }
+    int64_t CmdView::GetInterval() const
+    {
+        return AsFBCommand(fCmd).interval();
+    }
+    fair::mq::State CmdView::GetTargetState() const
+    {
+        return GetMQState(AsFBCommand(fCmd).state());
+    }
+    fair::mq::Transition CmdView::GetTransition() const
+    {
+        return GetMQTransition(AsFBCommand(fCmd).transition());
+    }
+    Result CmdView::GetResult() const
+    {
+        return odc::cc::GetResult(AsFBCommand(fCmd).result());
+    }
+    string_view CmdView::GetConfig() const
+    {
+        return AsStringView(AsFBCommand(fCmd).config_string());
+    }
+    fair::mq::State CmdView::GetLastState() const
+    {
+        return GetMQState(AsFBCommand(fCmd).last_state());
+    }
+    fair::mq::State CmdView::GetCurrentState() const
+    {
+        return GetMQState(AsFBCommand(fCmd).current_state());
+    }
+    string_view CmdView::GetQuery() const
+    {
+        return AsStringView(AsFBCommand(fCmd).property_query());
+    }
+    size_t CmdView::GetNumProps() const
+    {
+        auto const props = AsFBCommand(fCmd).properties();
+        return props == nullptr ? 0 : props->size();
+    }
+    pair<string_view, string_view> CmdView::GetProp(size_t i) const
+    {
+        auto const prop = AsFBCommand(fCmd).properties()->Get(i);
+        return { AsStringView(prop->key()), AsStringView(prop->value()) };
+    }
+    vector<pair<string, string>> CmdView::GetProps() const
+    {
+        vector<pair<string, string>> properties;
+        properties.reserve(GetNumProps());
+        for (size_t i = 0; i < GetNumProps(); ++i)
+        {
+            auto const prop = GetProp(i);
+            properties.emplace_back(prop.first, prop.second);
+        }
+        return properties;
+    }
 
-        for (unsigned int i = 0; i < cmds->size(); ++i)
+    size_t CmdView::GetNumStateChanges() const
+    {
+        auto const stateChanges = AsFBCommand(fCmd).state_changes();
+        return stateChanges == nullptr ? 0 : stateChanges->size();
+    }
+    StateChangeEntry CmdView::GetStateChange(size_t i) const
+    {
+        auto const e = AsFBCommand(fCmd).state_changes()->Get(i);
+        return { e->task_id(), GetMQState(e->last_state()), GetMQState(e->current_state()), e->timestamp() };
+    }
+
+    unique_ptr<Cmd> CmdView::ToCmd() const
+    {
+        switch (GetType())
         {
-            const FBCommand& cmdPtr = *(cmds->Get(i));
-            switch (cmdPtr.command_id())
+            case Type::check_state:
+                return make<CheckState>();
+            case Type::change_state:
+                return make<ChangeState>(GetTransition());
+            case Type::dump_config:
+                return make<DumpConfig>();
+            case Type::subscribe_to_state_change:
+                return make<SubscribeToStateChange>(GetInterval());
+            case Type::unsubscribe_from_state_change:
+                return make<UnsubscribeFromStateChange>();
+            case Type::state_change_exiting_received:
+                return make<StateChangeExitingReceived>();
+            case Type::get_properties:
+                return make<GetProperties>(GetRequestId(), string(GetQuery()));
+            case Type::set_properties:
+                return make<SetProperties>(GetRequestId(), GetProps());
+            case Type::subscription_heartbeat:
+                return make<SubscriptionHeartbeat>(GetInterval());
+            case Type::change_state_to:
+                return make<ChangeStateTo>(GetTargetState());
+            case Type::current_state:
+                return make<CurrentState>(string(GetDeviceId()), GetCurrentState());
+            case Type::transition_status:
+                return make<TransitionStatus>(
+                    string(GetDeviceId()), GetTaskId(), GetResult(), GetTransition(), GetCurrentState());
+            case Type::config:
+                return make<Config>(string(GetDeviceId()), string(GetConfig()));
+            case Type::state_change_subscription:
+                return make<StateChangeSubscription>(string(GetDeviceId()), GetTaskId(), GetResult());
+            case Type::state_change_unsubscription:
+                return make<StateChangeUnsubscription>(string(GetDeviceId()), GetTaskId(), GetResult());
+            case Type::state_change:
+                return make<StateChange>(string(GetDeviceId()), GetTaskId(), GetLastState(), GetCurrentState());
+            case Type::properties:
+                return make<Properties>(string(GetDeviceId()), GetRequestId(), GetResult(), GetProps());
+            case Type::properties_set:
+                return make<PropertiesSet>(string(GetDeviceId()), GetRequestId(), GetResult());
+            case Type::state_change_batch:
             {
-                case FBCmd_check_state:
-                    fCmds.emplace_back(make<CheckState>());
-                    break;
-                case FBCmd_change_state:
-                    fCmds.emplace_back(make<ChangeState>(GetMQTransition(cmdPtr.transition())));
-                    break;
-                case FBCmd_dump_config:
-                    fCmds.emplace_back(make<DumpConfig>());
-                    break;
-                case FBCmd_subscribe_to_state_change:
-                    fCmds.emplace_back(make<SubscribeToStateChange>(cmdPtr.interval()));
-                    break;
-                case FBCmd_unsubscribe_from_state_change:
-                    fCmds.emplace_back(make<UnsubscribeFromStateChange>());
-                    break;
-                case FBCmd_state_change_exiting_received:
-                    fCmds.emplace_back(make<StateChangeExitingReceived>());
-                    break;
-                case FBCmd_get_properties:
-                    fCmds.emplace_back(make<GetProperties>(cmdPtr.request_id(), cmdPtr.property_query()->str()));
-                    break;
-                case FBCmd_set_properties:
-                {
-                    std::vector<std::pair<std::string, std::string>> properties;
-                    auto props = cmdPtr.properties();
-                    for (unsigned int j = 0; j < props->size(); ++j)
-                    {
-                        properties.emplace_back(props->Get(j)->key()->str(), props->Get(j)->value()->str());
-                    }
-                    fCmds.emplace_back(make<SetProperties>(cmdPtr.request_id(), properties));
-                }
-                break;
-                case FBCmd_subscription_heartbeat:
-                    fCmds.emplace_back(make<SubscriptionHeartbeat>(cmdPtr.interval()));
-                    break;
-                case FBCmd_current_state:
-                    fCmds.emplace_back(
-                        make<CurrentState>(cmdPtr.device_id()->str(), GetMQState(cmdPtr.current_state())));
-                    break;
-                case FBCmd_transition_status:
-                    fCmds.emplace_back(make<TransitionStatus>(cmdPtr.device_id()->str(),
-                                                              cmdPtr.task_id(),
-                                                              GetResult(cmdPtr.result()),
-                                                              GetMQTransition(cmdPtr.transition()),
-                                                              GetMQState(cmdPtr.current_state())));
-                    break;
-                case FBCmd_config:
-                    fCmds.emplace_back(make<Config>(cmdPtr.device_id()->str(), cmdPtr.config_string()->str()));
-                    break;
-                case FBCmd_state_change_subscription:
-                    fCmds.emplace_back(make<StateChangeSubscription>(
-                        cmdPtr.device_id()->str(), cmdPtr.task_id(), GetResult(cmdPtr.result())));
-                    break;
-                case FBCmd_state_change_unsubscription:
-                    fCmds.emplace_back(make<StateChangeUnsubscription>(
-                        cmdPtr.device_id()->str(), cmdPtr.task_id(), GetResult(cmdPtr.result())));
-                    break;
-                case FBCmd_state_change:
-                    fCmds.emplace_back(make<StateChange>(cmdPtr.device_id()->str(),
-                                                         cmdPtr.task_id(),
-                                                         GetMQState(cmdPtr.last_state()),
-                                                         GetMQState(cmdPtr.current_state())));
-                    break;
-                case FBCmd_properties:
+                vector<StateChangeEntry> stateChanges;
+                stateChanges.reserve(GetNumStateChanges());
+                for (size_t i = 0; i < GetNumStateChanges(); ++i)
                 {
-                    std::vector<std::pair<std::string, std::string>> properties;
-                    auto props = cmdPtr.properties();
-                    for (unsigned int j = 0; j < props->size(); ++j)
-                    {
-                        properties.emplace_back(props->Get(j)->key()->str(), props->Get(j)->value()->str());
-                    }
-                    fCmds.emplace_back(make<Properties>(
-                        cmdPtr.device_id()->str(), cmdPtr.request_id(), GetResult(cmdPtr.result()), properties));
+                    stateChanges.push_back(GetStateChange(i));
                 }
-                break;
-                case FBCmd_properties_set:
-                    fCmds.emplace_back(make<PropertiesSet>(
-                        cmdPtr.device_id()->str(), cmdPtr.request_id(), GetResult(cmdPtr.result())));
-                    break;
-                default:
-                    throw CommandFormatError("unrecognized command type given to odc::cc::Cmds::Deserialize()");
-                    break;
+                return make<StateChangeBatch>(move(stateChanges));
             }
+            default:
+                throw Cmds::CommandFormatError("unrecognized command type given to odc::cc::CmdView::ToCmd()");
+        }
+    }
+
+    CmdsView::CmdsView(string_view buffer)
+        : fCmds(nullptr)
+    {
+        flatbuffers::Verifier verifier(reinterpret_cast<const uint8_t*>(buffer.data()), buffer.size());
+        if (!VerifyFBCommandsBuffer(verifier))
+        {
+            throw Cmds::CommandFormatError("CmdsView got a buffer which does not hold serialized commands");
         }
+        fCmds = GetFBCommands(buffer.data())->commands();
+    }
+
+    size_t CmdsView::Size() const
+    {
+        auto const cmds = static_cast<const flatbuffers::Vector<flatbuffers::Offset<FBCommand>>*>(fCmds);
+        return cmds == nullptr ? 0 : cmds->size();
+    }
+
+    CmdView CmdsView::At(size_t i) const
+    {
+        auto const cmds = static_cast<const flatbuffers::Vector<flatbuffers::Offset<FBCommand>>*>(fCmds);
+        return CmdView(cmds->Get(i));
     }
 
 } // namespace odc::cc
@@ -11,9 +11,12 @@
 
 #include <fairmq/States.h>
 
+#include <cstdint>
+#include <iterator>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <utility> // move
 #include <vector>
@@ -44,6 +47,7 @@ namespace odc::cc
         get_properties,                // args: { request_id, property_query }
         set_properties,                // args: { request_id, properties }
         subscription_heartbeat,        // args: { interval }
+        change_state_to,               // args: { state }
 
         current_state,               // args: { device_id, current_state }
         transition_status,           // args: { device_id, task_id, Result, transition, current_state }
@@ -52,7 +56,8 @@ namespace odc::cc
         state_change_unsubscription, // args: { device_id, task_id, Result }
         state_change,                // args: { device_id, task_id, last_state, current_state }
         properties,                  // args: { device_id, request_id, Result, properties }
-        properties_set               // args: { device_id, request_id, Result }
+        properties_set,              // args: { device_id, request_id, Result }
+        state_change_batch           // args: { state_changes }
     };
 
     struct Cmd
@@ -101,6 +106,29 @@ namespace odc::cc
         fair::mq::Transition fTransition;
     };
 
+    /// Walk the device state machine to the target state on the device side, only the outcome of the whole walk is
+    /// reported back (one TransitionStatus with the last transition)
+    struct ChangeStateTo : Cmd
+    {
+        explicit ChangeStateTo(fair::mq::State targetState)
+            : Cmd(Type::change_state_to)
+            , fTargetState(targetState)
+        {
+        }
+
+        fair::mq::State GetTargetState() const
+        {
+            return fTargetState;
+        }
+        void SetTargetState(fair::mq::State targetState)
+        {
+            fTargetState = targetState;
+        }
+
+      private:
+        fair::mq::State fTargetState;
+    };
+
     struct DumpConfig : Cmd
     {
         explicit DumpConfig()
@@ -163,7 +191,7 @@ namespace odc::cc
         {
             fRequestId = requestId;
         }
-        auto GetQuery() const -> std::string
+        auto GetQuery() const -> const std::string&
         {
             return fQuery;
         }
@@ -194,7 +222,7 @@ namespace odc::cc
         {
             fRequestId = requestId;
         }
-        auto GetProps() const -> std::vector<std::pair<std::string, std::string>>
+        auto GetProps() const -> const std::vector<std::pair<std::string, std::string>>&
         {
             return fProperties;
         }
@@ -238,7 +266,7 @@ namespace odc::cc
         {
         }
 
-        std::string GetDeviceId() const
+        const std::string& GetDeviceId() const
         {
             return fDeviceId;
         }
@@ -276,7 +304,7 @@ namespace odc::cc
         {
         }
 
-        std::string GetDeviceId() const
+        const std::string& GetDeviceId() const
         {
             return fDeviceId;
         }
@@ -334,7 +362,7 @@ namespace odc::cc
         {
         }
 
-        std::string GetDeviceId() const
+        const std::string& GetDeviceId() const
         {
             return fDeviceId;
         }
@@ -342,7 +370,7 @@ namespace odc::cc
         {
             fDeviceId = deviceId;
         }
-        std::string GetConfig() const
+        const std::string& GetConfig() const
         {
             return fConfig;
         }
@@ -366,7 +394,7 @@ namespace odc::cc
         {
         }
 
-        std::string GetDeviceId() const
+        const std::string& GetDeviceId() const
         {
             return fDeviceId;
         }
@@ -407,7 +435,7 @@ namespace odc::cc
         {
         }
 
-        std::string GetDeviceId() const
+        const std::string& GetDeviceId() const
         {
             return fDeviceId;
         }
@@ -452,7 +480,7 @@ namespace odc::cc
         {
         }
 
-        std::string GetDeviceId() const
+        const std::string& GetDeviceId() const
         {
             return fDeviceId;
         }
@@ -492,6 +520,44 @@ namespace odc::cc
         fair::mq::State fCurrentState;
     };
 
+    /// @brief One state change of a StateChangeBatch
+    struct StateChangeEntry
+    {
+        uint64_t taskId;
+        fair::mq::State lastState;
+        fair::mq::State currentState;
+        int64_t timestamp; ///< microseconds since epoch, when currentState was entered
+    };
+
+    /// @brief State changes of one or more tasks in a single command
+    ///
+    /// Carries fixed-size entries without device ids, several transitions of one device or the changes of many
+    /// devices relayed together take a fraction of the bytes of separate StateChange commands.
+    struct StateChangeBatch : Cmd
+    {
+        explicit StateChangeBatch(std::vector<StateChangeEntry> stateChanges = {})
+            : Cmd(Type::state_change_batch)
+            , fStateChanges(std::move(stateChanges))
+        {
+        }
+
+        auto GetStateChanges() const -> const std::vector<StateChangeEntry>&
+        {
+            return fStateChanges;
+        }
+        auto SetStateChanges(std::vector<StateChangeEntry> stateChanges) -> void
+        {
+            fStateChanges = std::move(stateChanges);
+        }
+        auto AddStateChange(const StateChangeEntry& stateChange) -> void
+        {
+            fStateChanges.push_back(stateChange);
+        }
+
+      private:
+        std::vector<StateChangeEntry> fStateChanges;
+    };
+
     struct Properties : Cmd
     {
         Properties(std::string deviceId,
@@ -506,7 +572,7 @@ namespace odc::cc
         {
         }
 
-        auto GetDeviceId() const -> std::string
+        auto GetDeviceId() const -> const std::string&
         {
             return fDeviceId;
         }
@@ -530,7 +596,7 @@ namespace odc::cc
         {
             fResult = result;
         }
-        auto GetProps() const -> std::vector<std::pair<std::string, std::string>>
+        auto GetProps() const -> const std::vector<std::pair<std::string, std::string>>&
         {
             return fProperties;
         }
@@ -556,7 +622,7 @@ namespace odc::cc
         {
         }
 
-        auto GetDeviceId() const -> std::string
+        auto GetDeviceId() const -> const std::string&
         {
             return fDeviceId;
         }
@@ -674,6 +740,120 @@ namespace odc::cc
         }
     };
 
+    /// @brief Read-only command inside a binary serialized buffer, see CmdsView
+    ///
+    /// The accessors read straight from the buffer, strings are returned as views into it. Accessors of fields the
+    /// command type does not carry return the default value. Valid as long as the buffer.
+    struct CmdView
+    {
+        Type GetType() const;
+        std::string_view GetDeviceId() const;
+        uint64_t GetTaskId() const;
+        std::size_t GetRequestId() const;
+        int64_t GetInterval() const;
+        fair::mq::State GetTargetState() const;
+        fair::mq::Transition GetTransition() const;
+        Result GetResult() const;
+        std::string_view GetConfig() const;
+        fair::mq::State GetLastState() const;
+        fair::mq::State GetCurrentState() const;
+        std::string_view GetQuery() const;
+        std::size_t GetNumProps() const;
+        std::pair<std::string_view, std::string_view> GetProp(std::size_t i) const;
+        /// @brief Copy of all properties
+        std::vector<std::pair<std::string, std::string>> GetProps() const;
+        std::size_t GetNumStateChanges() const;
+        StateChangeEntry GetStateChange(std::size_t i) const;
+
+        /// @brief Owning copy of the command
+        std::unique_ptr<Cmd> ToCmd() const;
+
+      private:
+        friend struct CmdsView;
+        explicit CmdView(const void* cmd)
+            : fCmd(cmd)
+        {
+        }
+
+        const void* fCmd; ///< FBCommand, the generated FlatBuffers types are not part of this header
+    };
+
+    /// @brief Lazy view of binary serialized commands, decodes nothing up front and does not allocate
+    ///
+    /// The buffer is verified on construction, but neither copied nor owned: it has to outlive the view and all
+    /// CmdViews taken from it. Use Cmds::Deserialize() for an owning copy.
+    struct CmdsView
+    {
+        /// @throws Cmds::CommandFormatError if the buffer does not hold serialized commands
+        explicit CmdsView(std::string_view buffer);
+
+        CmdView At(std::size_t i) const;
+        std::size_t Size() const;
+
+        struct const_iterator
+        {
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = CmdView;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = CmdView;
+
+            CmdView operator*() const
+            {
+                return fView->At(fIndex);
+            }
+            const_iterator& operator++()
+            {
+                ++fIndex;
+                return *this;
+            }
+            const_iterator operator++(int)
+            {
+                const_iterator it(*this);
+                ++fIndex;
+                return it;
+            }
+            bool operator==(const const_iterator& other) const
+            {
+                return fIndex == other.fIndex;
+            }
+            bool operator!=(const const_iterator& other) const
+            {
+                return fIndex != other.fIndex;
+            }
+
+            const CmdsView* fView;
+            std::size_t fIndex;
+        };
+
+        const_iterator begin() const
+        {
+            return { this, 0 };
+        }
+        const_iterator end() const
+        {
+            return { this, Size() };
+        }
+
+      private:
+        const void* fCmds; ///< vector of FBCommand, null if the buffer holds none
+    };
+
+    /// @brief Binary serialized single commands which are sent over and over with the same arguments
+    ///
+    /// Each buffer is encoded on first use and shared afterwards, the references stay valid for the lifetime of the
+    /// process. Entries are never evicted, the arguments are enums or heartbeat intervals, of which a controller only
+    /// uses a few.
+    struct EncodedCmds
+    {
+        static const std::string& ChangeState(fair::mq::Transition transition);
+        static const std::string& ChangeStateTo(fair::mq::State state);
+        static const std::string& StateChangeExitingReceived();
+        static const std::string& SubscribeToStateChange(int64_t interval);
+        static const std::string& SubscriptionHeartbeat(int64_t interval);
+        static const std::string& UnsubscribeFromStateChange();
+    };
+
     std::string GetResultName(const Result result);
     std::string GetTypeName(const Type type);
 
@@ -0,0 +1,131 @@
+/********************************************************************************
+ * Copyright (C) 2019-2021 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include "CommandIngress.h"
+#include "Logger.h"
+
+#include <algorithm>
+
+namespace odc::core
+{
+
+    CommandIngress::CommandIngress(BatchHandler handler, std::size_t maxBatchSize)
+        : fHandler(std::move(handler))
+        , fMaxBatchSize(std::max(maxBatchSize, std::size_t(1)))
+        , fQueue(fMaxBatchSize)
+        , fIdle(false)
+        , fStop(false)
+        , fWindow(0)
+        , fThread(&CommandIngress::Run, this)
+    {
+    }
+
+    CommandIngress::~CommandIngress()
+    {
+        Stop();
+        Item* item = nullptr;
+        while (fQueue.pop(item))
+        {
+            delete item;
+        }
+    }
+
+    auto CommandIngress::Push(std::string msg, std::uint64_t senderId) -> void
+    {
+        if (fStop)
+        {
+            return;
+        }
+        fQueue.push(new Item{ std::move(msg), senderId });
+        // pairs with the fence in Run(): either the decoder sees the new item, or we see it going asleep
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (fIdle.exchange(false))
+        {
+            std::lock_guard<std::mutex> lk(fMtx);
+            fCV.notify_one();
+        }
+    }
+
+    auto CommandIngress::Stop() -> void
+    {
+        {
+            std::lock_guard<std::mutex> lk(fMtx);
+            fStop = true;
+        }
+        fCV.notify_one();
+        if (fThread.joinable())
+        {
+            fThread.join();
+        }
+    }
+
+    auto CommandIngress::SetCoalescingWindow(std::chrono::microseconds window) -> void
+    {
+        fWindow = std::max(window, std::chrono::microseconds(0)).count();
+    }
+
+    auto CommandIngress::Drain(std::vector<Item>& batch) -> std::size_t
+    {
+        Item* item = nullptr;
+        std::size_t count = 0;
+        while (batch.size() < fMaxBatchSize && fQueue.pop(item))
+        {
+            batch.push_back(std::move(*item));
+            delete item;
+            ++count;
+        }
+        return count;
+    }
+
+    auto CommandIngress::Run() -> void
+    {
+        std::vector<Item> batch;
+        batch.reserve(fMaxBatchSize);
+
+        while (true)
+        {
+            if (Drain(batch) > 0)
+            {
+                std::chrono::microseconds const window(fWindow.load());
+                if (window.count() > 0 && batch.size() < fMaxBatchSize && !fStop)
+                {
+                    std::this_thread::sleep_for(window);
+                    Drain(batch);
+                }
+                try
+                {
+                    fHandler(batch);
+                }
+                catch (const std::exception& e)
+                {
+                    OLOG(ESeverity::error) << "Exception while handling incoming commands: " << e.what();
+                }
+                batch.clear();
+                continue;
+            }
+
+            if (fStop)
+            {
+                return;
+            }
+
+            fIdle = true;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (Drain(batch) > 0)
+            {
+                // raced with a producer, which may or may not have seen us idle
+                fIdle = false;
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lk(fMtx);
+            fCV.wait(lk, [&]() { return !fIdle || fStop; });
+        }
+    }
+
+} // namespace odc::core
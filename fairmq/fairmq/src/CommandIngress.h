@@ -0,0 +1,83 @@
+/********************************************************************************
+ * Copyright (C) 2019-2021 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef __ODC__CommandIngress__
+#define __ODC__CommandIngress__
+
+#include <boost/lockfree/queue.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace odc::core
+{
+
+    /**
+     * @brief Ingress stage for incoming custom command messages
+     *
+     * Producers, e.g. the DDS intercom callback thread, only enqueue the raw message into a lock-free
+     * multi-producer queue. A single decoder thread drains the queue and hands the messages to the batch handler in
+     * batches of up to maxBatchSize, in the order they were enqueued. The decoder sleeps while the queue is empty,
+     * producers only touch the wake-up lock when the decoder is asleep. With a coalescing window, the decoder waits
+     * for that long after the first message of a batch, so that a burst ends up in fewer, larger batches.
+     *
+     * @par Thread Safety
+     * @e Distinct @e objects: Safe.@n
+     * @e Shared @e objects: Safe.
+     */
+    class CommandIngress
+    {
+      public:
+        struct Item
+        {
+            std::string msg;
+            std::uint64_t senderId;
+        };
+        using BatchHandler = std::function<void(std::vector<Item>&)>;
+
+        /// @param handler invoked on the decoder thread with every batch
+        /// @param maxBatchSize upper bound of the number of messages per batch
+        explicit CommandIngress(BatchHandler handler, std::size_t maxBatchSize = 1024);
+
+        CommandIngress(const CommandIngress&) = delete;
+        CommandIngress& operator=(const CommandIngress&) = delete;
+        ~CommandIngress();
+
+        /// @brief Enqueue a message, does not block on the decoder
+        auto Push(std::string msg, std::uint64_t senderId) -> void;
+        /// @brief Handle the messages enqueued so far and join the decoder thread, further messages are dropped
+        auto Stop() -> void;
+        /// @brief Set the time to wait for more messages before handling a batch, 0 (default) handles right away
+        auto SetCoalescingWindow(std::chrono::microseconds window) -> void;
+
+      private:
+        auto Run() -> void;
+        /// @return number of messages moved into the batch
+        auto Drain(std::vector<Item>& batch) -> std::size_t;
+
+        BatchHandler const fHandler;
+        std::size_t const fMaxBatchSize;
+        boost::lockfree::queue<Item*> fQueue;
+        std::atomic<bool> fIdle; ///< decoder is (about to go) asleep
+        std::atomic<bool> fStop;
+        std::atomic<std::chrono::microseconds::rep> fWindow;
+        std::mutex fMtx; ///< only for waking up the decoder
+        std::condition_variable fCV;
+        std::thread fThread;
+    };
+
+} // namespace odc::core
+
+#endif /* __ODC__CommandIngress__ */
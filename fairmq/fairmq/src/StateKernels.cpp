@@ -0,0 +1,405 @@
+/********************************************************************************
+ * Copyright (C) 2019-2021 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include "StateKernels.h"
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ODC_STATE_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+namespace odc::core
+{
+
+    namespace
+    {
+        // All kernels work on chunks of 64 states, which map onto one 64 bit equality word. The remaining tail of
+        // less than 64 states is always handled by the scalar code.
+        constexpr std::size_t chunkSize = 64;
+
+        auto PushMismatches(std::uint64_t mismatches, std::size_t base, std::vector<std::size_t>& indices) -> void
+        {
+            while (mismatches != 0)
+            {
+                indices.push_back(base + static_cast<std::size_t>(__builtin_ctzll(mismatches)));
+                mismatches &= mismatches - 1;
+            }
+        }
+
+        /// equality word of up to 64 states
+        auto EqualWordScalar(const std::uint8_t* states, std::size_t size, std::uint8_t state) -> std::uint64_t
+        {
+            std::uint64_t word = 0;
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                word |= static_cast<std::uint64_t>(states[i] == state) << i;
+            }
+            return word;
+        }
+
+        auto LowBits(std::size_t size) -> std::uint64_t
+        {
+            return size >= chunkSize ? ~std::uint64_t(0) : (std::uint64_t(1) << size) - 1;
+        }
+
+        // Scalar
+
+        auto AllStatesEqualScalar(const std::uint8_t* states, std::size_t size, std::uint8_t state) -> bool
+        {
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                if (states[i] != state)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        auto CountStatesScalar(const std::uint8_t* states, std::size_t size, std::size_t* counts, std::size_t numStates)
+            -> void
+        {
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                if (states[i] < numStates)
+                {
+                    ++counts[states[i]];
+                }
+            }
+        }
+
+        auto StatesEqualMaskScalar(const std::uint8_t* states,
+                                   std::size_t size,
+                                   std::uint8_t state,
+                                   std::uint64_t* mask) -> void
+        {
+            for (std::size_t base = 0; base < size; base += chunkSize)
+            {
+                mask[base / chunkSize] = EqualWordScalar(states + base, std::min(chunkSize, size - base), state);
+            }
+        }
+
+        auto FindStateMismatchesScalar(const std::uint8_t* states,
+                                       std::size_t size,
+                                       std::uint8_t expected,
+                                       std::vector<std::size_t>& indices) -> void
+        {
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                if (states[i] != expected)
+                {
+                    indices.push_back(i);
+                }
+            }
+        }
+
+#ifdef ODC_STATE_KERNELS_X86
+
+        // SSE2, part of the x86-64 baseline
+
+        auto EqualWordSse2(const std::uint8_t* states, __m128i state) -> std::uint64_t
+        {
+            std::uint64_t word = 0;
+            for (std::size_t k = 0; k < 4; ++k)
+            {
+                __m128i const v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(states + 16 * k));
+                auto const bits = static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, state)));
+                word |= static_cast<std::uint64_t>(bits) << (16 * k);
+            }
+            return word;
+        }
+
+        auto AllStatesEqualSse2(const std::uint8_t* states, std::size_t size, std::uint8_t state) -> bool
+        {
+            __m128i const s = _mm_set1_epi8(static_cast<char>(state));
+            std::size_t base = 0;
+            for (; base + chunkSize <= size; base += chunkSize)
+            {
+                if (EqualWordSse2(states + base, s) != ~std::uint64_t(0))
+                {
+                    return false;
+                }
+            }
+            return AllStatesEqualScalar(states + base, size - base, state);
+        }
+
+        // The histogram kernels count in byte lanes (a matching lane compares to -1, which is subtracted) for a group
+        // of states per pass and sum up the lanes before they can overflow.
+        constexpr std::size_t countGroup = 8;
+        constexpr std::size_t maxLaneCount = 255;
+
+        /// sum of the two 64 bit lanes
+        auto SumLanes(__m128i sums) -> std::size_t
+        {
+            return static_cast<std::size_t>(_mm_cvtsi128_si64(sums)) +
+                   static_cast<std::size_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(sums, sums)));
+        }
+
+        auto CountStatesSse2(const std::uint8_t* states, std::size_t size, std::size_t* counts, std::size_t numStates)
+            -> void
+        {
+            std::size_t const end = size - size % 16;
+            for (std::size_t first = 0; first < numStates; first += countGroup)
+            {
+                std::size_t const n = std::min(countGroup, numStates - first);
+                __m128i needles[countGroup];
+                for (std::size_t k = 0; k < n; ++k)
+                {
+                    needles[k] = _mm_set1_epi8(static_cast<char>(first + k));
+                }
+                for (std::size_t base = 0; base < end;)
+                {
+                    __m128i lanes[countGroup];
+                    for (std::size_t k = 0; k < n; ++k)
+                    {
+                        lanes[k] = _mm_setzero_si128();
+                    }
+                    std::size_t const stop = std::min(end, base + 16 * maxLaneCount);
+                    for (; base < stop; base += 16)
+                    {
+                        __m128i const v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(states + base));
+                        for (std::size_t k = 0; k < n; ++k)
+                        {
+                            lanes[k] = _mm_sub_epi8(lanes[k], _mm_cmpeq_epi8(v, needles[k]));
+                        }
+                    }
+                    for (std::size_t k = 0; k < n; ++k)
+                    {
+                        __m128i const sums = _mm_sad_epu8(lanes[k], _mm_setzero_si128());
+                        counts[first + k] += SumLanes(sums);
+                    }
+                }
+            }
+            CountStatesScalar(states + end, size - end, counts, numStates);
+        }
+
+        auto StatesEqualMaskSse2(const std::uint8_t* states, std::size_t size, std::uint8_t state, std::uint64_t* mask)
+            -> void
+        {
+            __m128i const s = _mm_set1_epi8(static_cast<char>(state));
+            std::size_t base = 0;
+            for (; base + chunkSize <= size; base += chunkSize)
+            {
+                mask[base / chunkSize] = EqualWordSse2(states + base, s);
+            }
+            StatesEqualMaskScalar(states + base, size - base, state, mask + base / chunkSize);
+        }
+
+        auto FindStateMismatchesSse2(const std::uint8_t* states,
+                                     std::size_t size,
+                                     std::uint8_t expected,
+                                     std::vector<std::size_t>& indices) -> void
+        {
+            __m128i const s = _mm_set1_epi8(static_cast<char>(expected));
+            std::size_t base = 0;
+            for (; base + chunkSize <= size; base += chunkSize)
+            {
+                PushMismatches(~EqualWordSse2(states + base, s), base, indices);
+            }
+            std::uint64_t const tail = EqualWordScalar(states + base, size - base, expected);
+            PushMismatches(~tail & LowBits(size - base), base, indices);
+        }
+
+        // AVX2
+
+        __attribute__((target("avx2"))) inline auto EqualWordAvx2(const std::uint8_t* states, __m256i state)
+            -> std::uint64_t
+        {
+            __m256i const lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(states));
+            __m256i const hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(states + 32));
+            auto const loBits = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, state)));
+            auto const hiBits = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, state)));
+            return static_cast<std::uint64_t>(loBits) | (static_cast<std::uint64_t>(hiBits) << 32);
+        }
+
+        __attribute__((target("avx2"))) auto AllStatesEqualAvx2(const std::uint8_t* states,
+                                                                std::size_t size,
+                                                                std::uint8_t state) -> bool
+        {
+            __m256i const s = _mm256_set1_epi8(static_cast<char>(state));
+            std::size_t base = 0;
+            for (; base + chunkSize <= size; base += chunkSize)
+            {
+                if (EqualWordAvx2(states + base, s) != ~std::uint64_t(0))
+                {
+                    return false;
+                }
+            }
+            return AllStatesEqualScalar(states + base, size - base, state);
+        }
+
+        __attribute__((target("avx2"))) auto CountStatesAvx2(const std::uint8_t* states,
+                                                              std::size_t size,
+                                                              std::size_t* counts,
+                                                              std::size_t numStates) -> void
+        {
+            std::size_t const end = size - size % 32;
+            for (std::size_t first = 0; first < numStates; first += countGroup)
+            {
+                std::size_t const n = std::min(countGroup, numStates - first);
+                __m256i needles[countGroup];
+                for (std::size_t k = 0; k < n; ++k)
+                {
+                    needles[k] = _mm256_set1_epi8(static_cast<char>(first + k));
+                }
+                for (std::size_t base = 0; base < end;)
+                {
+                    __m256i lanes[countGroup];
+                    for (std::size_t k = 0; k < n; ++k)
+                    {
+                        lanes[k] = _mm256_setzero_si256();
+                    }
+                    std::size_t const stop = std::min(end, base + 32 * maxLaneCount);
+                    for (; base < stop; base += 32)
+                    {
+                        __m256i const v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(states + base));
+                        for (std::size_t k = 0; k < n; ++k)
+                        {
+                            lanes[k] = _mm256_sub_epi8(lanes[k], _mm256_cmpeq_epi8(v, needles[k]));
+                        }
+                    }
+                    for (std::size_t k = 0; k < n; ++k)
+                    {
+                        __m256i const sums256 = _mm256_sad_epu8(lanes[k], _mm256_setzero_si256());
+                        __m128i const sums = _mm_add_epi64(_mm256_castsi256_si128(sums256),
+                                                           _mm256_extracti128_si256(sums256, 1));
+                        counts[first + k] += SumLanes(sums);
+                    }
+                }
+            }
+            CountStatesScalar(states + end, size - end, counts, numStates);
+        }
+
+        __attribute__((target("avx2"))) auto StatesEqualMaskAvx2(const std::uint8_t* states,
+                                                                 std::size_t size,
+                                                                 std::uint8_t state,
+                                                                 std::uint64_t* mask) -> void
+        {
+            __m256i const s = _mm256_set1_epi8(static_cast<char>(state));
+            std::size_t base = 0;
+            for (; base + chunkSize <= size; base += chunkSize)
+            {
+                mask[base / chunkSize] = EqualWordAvx2(states + base, s);
+            }
+            StatesEqualMaskScalar(states + base, size - base, state, mask + base / chunkSize);
+        }
+
+        __attribute__((target("avx2"))) auto FindStateMismatchesAvx2(const std::uint8_t* states,
+                                                                     std::size_t size,
+                                                                     std::uint8_t expected,
+                                                                     std::vector<std::size_t>& indices) -> void
+        {
+            __m256i const s = _mm256_set1_epi8(static_cast<char>(expected));
+            std::size_t base = 0;
+            for (; base + chunkSize <= size; base += chunkSize)
+            {
+                PushMismatches(~EqualWordAvx2(states + base, s), base, indices);
+            }
+            std::uint64_t const tail = EqualWordScalar(states + base, size - base, expected);
+            PushMismatches(~tail & LowBits(size - base), base, indices);
+        }
+
+#endif // ODC_STATE_KERNELS_X86
+
+        struct StateKernelTable
+        {
+            StateKernelIsa isa;
+            bool (*allStatesEqual)(const std::uint8_t*, std::size_t, std::uint8_t);
+            void (*countStates)(const std::uint8_t*, std::size_t, std::size_t*, std::size_t);
+            void (*statesEqualMask)(const std::uint8_t*, std::size_t, std::uint8_t, std::uint64_t*);
+            void (*findStateMismatches)(const std::uint8_t*, std::size_t, std::uint8_t, std::vector<std::size_t>&);
+        };
+
+        constexpr StateKernelTable scalarKernels{ StateKernelIsa::Scalar,
+                                                  AllStatesEqualScalar,
+                                                  CountStatesScalar,
+                                                  StatesEqualMaskScalar,
+                                                  FindStateMismatchesScalar };
+#ifdef ODC_STATE_KERNELS_X86
+        constexpr StateKernelTable sse2Kernels{
+            StateKernelIsa::SSE2, AllStatesEqualSse2, CountStatesSse2, StatesEqualMaskSse2, FindStateMismatchesSse2
+        };
+        constexpr StateKernelTable avx2Kernels{
+            StateKernelIsa::AVX2, AllStatesEqualAvx2, CountStatesAvx2, StatesEqualMaskAvx2, FindStateMismatchesAvx2
+        };
+#endif
+
+        auto SelectKernels(StateKernelIsa isa) -> const StateKernelTable*
+        {
+#ifdef ODC_STATE_KERNELS_X86
+            if (isa == StateKernelIsa::AVX2 && __builtin_cpu_supports("avx2"))
+            {
+                return &avx2Kernels;
+            }
+            if (isa != StateKernelIsa::Scalar)
+            {
+                return &sse2Kernels;
+            }
+#endif
+            return &scalarKernels;
+        }
+
+        auto ActiveKernels() -> std::atomic<const StateKernelTable*>&
+        {
+            static std::atomic<const StateKernelTable*> kernels(SelectKernels(StateKernelIsa::AVX2));
+            return kernels;
+        }
+    } // namespace
+
+    auto GetStateKernelIsa() -> StateKernelIsa
+    {
+        return ActiveKernels().load()->isa;
+    }
+
+    auto SetStateKernelIsa(StateKernelIsa isa) -> StateKernelIsa
+    {
+        auto const kernels = SelectKernels(isa);
+        ActiveKernels().store(kernels);
+        return kernels->isa;
+    }
+
+    auto GetStateKernelIsaName(StateKernelIsa isa) -> const char*
+    {
+        switch (isa)
+        {
+            case StateKernelIsa::AVX2:
+                return "AVX2";
+            case StateKernelIsa::SSE2:
+                return "SSE2";
+            default:
+                return "scalar";
+        }
+    }
+
+    auto AllStatesEqual(const std::uint8_t* states, std::size_t size, std::uint8_t state) -> bool
+    {
+        return ActiveKernels().load()->allStatesEqual(states, size, state);
+    }
+
+    auto CountStates(const std::uint8_t* states, std::size_t size, std::size_t* counts, std::size_t numStates) -> void
+    {
+        ActiveKernels().load()->countStates(states, size, counts, numStates);
+    }
+
+    auto StatesEqualMask(const std::uint8_t* states, std::size_t size, std::uint8_t state, std::uint64_t* mask) -> void
+    {
+        ActiveKernels().load()->statesEqualMask(states, size, state, mask);
+    }
+
+    auto FindStateMismatches(const std::uint8_t* states, std::size_t size, std::uint8_t expected)
+        -> std::vector<std::size_t>
+    {
+        std::vector<std::size_t> indices;
+        ActiveKernels().load()->findStateMismatches(states, size, expected, indices);
+        return indices;
+    }
+
+} // namespace odc::core
@@ -0,0 +1,57 @@
+/********************************************************************************
+ * Copyright (C) 2019-2021 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef __ODC__StateKernels__
+#define __ODC__StateKernels__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace odc::core
+{
+
+    /**
+     * @brief Scan kernels over device states stored as one byte per device (see DeviceStateColumns)
+     *
+     * The implementation is selected once at runtime: AVX2 or SSE2 on x86-64 if the CPU supports it, portable
+     * scalar code otherwise.
+     */
+    enum class StateKernelIsa
+    {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    /// @brief Instruction set used by the state kernels
+    auto GetStateKernelIsa() -> StateKernelIsa;
+    /// @brief Force an instruction set, falls back to the best supported one below it (for tests and benchmarks)
+    auto SetStateKernelIsa(StateKernelIsa isa) -> StateKernelIsa;
+    auto GetStateKernelIsaName(StateKernelIsa isa) -> const char*;
+
+    /// @brief Whether all states equal the given state, true for an empty range
+    auto AllStatesEqual(const std::uint8_t* states, std::size_t size, std::uint8_t state) -> bool;
+
+    /// @brief Count states per value
+    /// @param counts array of numStates entries, counts[s] is incremented by the number of states equal to s,
+    ///               values >= numStates are not counted
+    auto CountStates(const std::uint8_t* states, std::size_t size, std::size_t* counts, std::size_t numStates) -> void;
+
+    /// @brief Equality bitmask, bit i of mask[i / 64] is set if states[i] == state
+    /// @param mask array of (size + 63) / 64 words, bits beyond size are cleared
+    auto StatesEqualMask(const std::uint8_t* states, std::size_t size, std::uint8_t state, std::uint64_t* mask)
+        -> void;
+
+    /// @brief Ascending indices of the states which differ from the expected state
+    auto FindStateMismatches(const std::uint8_t* states, std::size_t size, std::uint8_t expected)
+        -> std::vector<std::size_t>;
+
+} // namespace odc::core
+
+#endif /* __ODC__StateKernels__ */
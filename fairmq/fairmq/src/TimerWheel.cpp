@@ -0,0 +1,172 @@
+/********************************************************************************
+ * Copyright (C) 2019-2021 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include "TimerWheel.h"
+
+#include <algorithm>
+
+namespace odc::core
+{
+
+    TimerWheel::TimerWheel(const boost::asio::any_io_executor& ex, Duration tick, std::size_t numSlots)
+        : fTimer(ex)
+        , fStart(Clock::now())
+        , fTick(std::max(tick, Duration(1)))
+        , fSlots(std::max(numSlots, std::size_t(1)))
+        , fCurrentTick(0)
+        , fArmedTick(0)
+        , fNextId(1)
+    {
+    }
+
+    TimerWheel::~TimerWheel()
+    {
+        fTimer.cancel();
+    }
+
+    auto TimerWheel::Schedule(Duration timeout, Callback callback) -> Id
+    {
+        std::lock_guard<std::mutex> lk(fMtx);
+        if (fTimers.empty())
+        {
+            // nothing expired while idle, skip the passed ticks
+            fCurrentTick = std::max(fCurrentTick, NowTick());
+        }
+
+        Duration const expiry =
+            std::chrono::duration_cast<Duration>(Clock::now() - fStart) + std::max(timeout, Duration(0));
+        std::uint64_t const deadline =
+            std::max<std::uint64_t>(fCurrentTick + 1, (expiry.count() + fTick.count() - 1) / fTick.count());
+
+        Id const id = fNextId++;
+        std::size_t const slot = deadline % fSlots.size();
+        fSlots[slot].push_back({ id, deadline, std::move(callback) });
+        fTimers.emplace(id, std::make_pair(slot, std::prev(fSlots[slot].end())));
+
+        if (fArmedTick == 0 || deadline < fArmedTick)
+        {
+            Arm();
+        }
+        return id;
+    }
+
+    auto TimerWheel::Cancel(Id id) -> bool
+    {
+        std::lock_guard<std::mutex> lk(fMtx);
+        auto const it = fTimers.find(id);
+        if (it == fTimers.end())
+        {
+            return false;
+        }
+        fSlots[it->second.first].erase(it->second.second);
+        fTimers.erase(it);
+        return true;
+    }
+
+    auto TimerWheel::CancelAll() -> void
+    {
+        std::lock_guard<std::mutex> lk(fMtx);
+        for (auto& slot : fSlots)
+        {
+            slot.clear();
+        }
+        fTimers.clear();
+        fArmedTick = 0;
+        fTimer.cancel();
+    }
+
+    auto TimerWheel::GetSize() const -> std::size_t
+    {
+        std::lock_guard<std::mutex> lk(fMtx);
+        return fTimers.size();
+    }
+
+    auto TimerWheel::NowTick() const -> std::uint64_t
+    {
+        return static_cast<std::uint64_t>((Clock::now() - fStart) / fTick);
+    }
+
+    auto TimerWheel::Expire(std::uint64_t tick, std::vector<Callback>& expired) -> void
+    {
+        auto& slot = fSlots[tick % fSlots.size()];
+        for (auto it = slot.begin(); it != slot.end();)
+        {
+            if (it->deadline <= tick)
+            {
+                expired.push_back(std::move(it->callback));
+                fTimers.erase(it->id);
+                it = slot.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    auto TimerWheel::Arm() -> void
+    {
+        fArmedTick = 0;
+        if (fTimers.empty())
+        {
+            return;
+        }
+
+        // Wake up at the next non-empty slot. Its timers may belong to a later round, in which case the wheel
+        // re-arms after that tick.
+        std::uint64_t tick = fCurrentTick + 1;
+        while (fSlots[tick % fSlots.size()].empty())
+        {
+            ++tick;
+        }
+        fArmedTick = tick;
+
+        fTimer.expires_at(fStart + tick * fTick);
+        fTimer.async_wait(
+            [weak = weak_from_this()](std::error_code ec)
+            {
+                if (auto self = weak.lock())
+                {
+                    self->OnTimer(ec);
+                }
+            });
+    }
+
+    auto TimerWheel::OnTimer(std::error_code ec) -> void
+    {
+        if (ec)
+        {
+            return;
+        }
+
+        std::vector<Callback> expired;
+        {
+            std::lock_guard<std::mutex> lk(fMtx);
+            std::uint64_t const now = NowTick();
+            if (fArmedTick == 0 || now < fArmedTick)
+            {
+                // superseded by a re-arm
+                return;
+            }
+            // a full round visits every slot once
+            std::uint64_t const first = std::max(fCurrentTick + 1, now >= fSlots.size() ? now - fSlots.size() + 1 : 0);
+            for (std::uint64_t tick = first; tick <= now; ++tick)
+            {
+                Expire(tick, expired);
+            }
+            fCurrentTick = now;
+            Arm();
+        }
+
+        for (auto& callback : expired)
+        {
+            callback();
+        }
+    }
+
+} // namespace odc::core
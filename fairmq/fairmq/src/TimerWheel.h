@@ -0,0 +1,101 @@
+/********************************************************************************
+ * Copyright (C) 2019-2021 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef __ODC__TimerWheel__
+#define __ODC__TimerWheel__
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace odc::core
+{
+
+    /**
+     * @brief Hashed timing wheel, manages many deadlines with a single steady_timer
+     *
+     * Timers are hashed by their deadline tick into a fixed number of slots. Scheduling and cancelling are O(1), the
+     * driving timer is only armed while timers are pending and wakes up at the next non-empty slot. All timers of
+     * the ticks that passed are expired in one batch, their callbacks are invoked on the executor outside of the
+     * internal lock. Deadlines are rounded up to the tick, a timer never fires early.
+     *
+     * Create with std::make_shared, the driving timer only holds a weak reference to the wheel.
+     *
+     * @par Thread Safety
+     * @e Distinct @e objects: Safe.@n
+     * @e Shared @e objects: Safe.
+     */
+    class TimerWheel : public std::enable_shared_from_this<TimerWheel>
+    {
+      public:
+        using Id = std::uint64_t;
+        using Callback = std::function<void()>;
+        using Clock = std::chrono::steady_clock;
+        using Duration = std::chrono::microseconds;
+
+        /// @param ex I/O executor the callbacks are invoked on
+        /// @param tick resolution of the deadlines
+        /// @param numSlots number of slots, timers further than numSlots ticks away are kept for several rounds
+        explicit TimerWheel(const boost::asio::any_io_executor& ex,
+                            Duration tick = std::chrono::milliseconds(10),
+                            std::size_t numSlots = 512);
+
+        TimerWheel(const TimerWheel&) = delete;
+        TimerWheel& operator=(const TimerWheel&) = delete;
+        ~TimerWheel();
+
+        /// @brief Schedule a callback to be invoked once the timeout has expired
+        /// @return id of the timer, never 0
+        auto Schedule(Duration timeout, Callback callback) -> Id;
+        /// @brief Cancel a pending timer, the callback is not invoked
+        /// @return false if the timer has already expired or was cancelled before
+        auto Cancel(Id id) -> bool;
+        /// @brief Cancel all pending timers
+        auto CancelAll() -> void;
+        /// @brief Number of pending timers
+        auto GetSize() const -> std::size_t;
+
+      private:
+        struct Entry
+        {
+            Id id;
+            std::uint64_t deadline; ///< in ticks since fStart
+            Callback callback;
+        };
+        using Slot = std::list<Entry>;
+
+        /// precondition: fMtx is locked.
+        auto NowTick() const -> std::uint64_t;
+        /// precondition: fMtx is locked.
+        auto Expire(std::uint64_t tick, std::vector<Callback>& expired) -> void;
+        /// precondition: fMtx is locked.
+        auto Arm() -> void;
+        auto OnTimer(std::error_code ec) -> void;
+
+        mutable std::mutex fMtx;
+        boost::asio::steady_timer fTimer;
+        Clock::time_point const fStart;
+        Duration const fTick;
+        std::vector<Slot> fSlots;
+        std::unordered_map<Id, std::pair<std::size_t, Slot::iterator>> fTimers; ///< id -> slot index, position
+        std::uint64_t fCurrentTick;                                             ///< all ticks up to here expired
+        std::uint64_t fArmedTick;                                               ///< 0 if not armed
+        Id fNextId;
+    };
+
+} // namespace odc::core
+
+#endif /* __ODC__TimerWheel__ */
@@ -11,15 +11,20 @@
 
 #include "AsioAsyncOp.h"
 #include "AsioBase.h"
+#include "CommandIngress.h"
 #include "CustomCommands.h"
 #include "Error.h"
 #include "MiscUtils.h"
 #include "Semaphore.h"
+#include "StateKernels.h"
+#include "TimerWheel.h"
 
 #include <boost/asio/associated_executor.hpp>
 #include <boost/asio/async_result.hpp>
+#include <boost/asio/post.hpp>
 #include <boost/asio/steady_timer.hpp>
 #include <boost/asio/system_executor.hpp>
+#include <boost/dynamic_bitset.hpp>
 
 #include <dds/Tools.h>
 #include <dds/Topology.h>
@@ -27,17 +32,24 @@
 #include <fairmq/States.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cmath>
 #include <condition_variable>
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <ostream>
 #include <set>
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -200,6 +212,25 @@ namespace odc::core
         }
     }
 
+    /// @brief DDS custom command condition selecting only the task with the given path
+    ///
+    /// DDS matches the condition as a regular expression against the task paths, the plain path of
+    /// .../Processor_1 would also select .../Processor_10.
+    inline std::string ExactTaskPathCondition(const std::string& path)
+    {
+        static std::string const special("\\^$.|?*+()[]{}");
+        std::string condition("^");
+        for (char const c : path)
+        {
+            if (special.find(c) != std::string::npos)
+            {
+                condition += '\\';
+            }
+            condition += c;
+        }
+        return condition + "$";
+    }
+
     struct DeviceStatus
     {
         bool subscribed_to_state_changes;
@@ -207,8 +238,8 @@ namespace odc::core
         DeviceState state;
         DDSTask::Id taskId;
         DDSCollection::Id collectionId;
-        int exitCode;
-        int signal;
+        int exitCode; ///< -1 until the task has exited
+        int signal;   ///< -1 until the task has exited
     };
 
     using DeviceProperty = std::pair<std::string, std::string>; /// pair := (key, value)
@@ -226,12 +257,96 @@ namespace odc::core
         FailedDevices failed;
     };
 
+    /// @brief Completion policy of a change state operation which does not wait for every device
+    ///
+    /// The operation completes successfully as soon as any of the set criteria is met: at least minDevices devices
+    /// have reached the target state, or at least minFraction of the selected devices have, or every selected
+    /// device of the requiredCollections has. Unset criteria (0, 0.0, empty) are ignored, without any criterion the
+    /// operation waits for every device. The remaining devices are reported as laggards.
+    struct ChangeStateQuorum
+    {
+        std::size_t minDevices = 0; ///< 0 for unset
+        double minFraction = 0.0;   ///< in [0, 1], 0 for unset
+        std::vector<DDSCollection::Id> requiredCollections; ///< empty for unset
+    };
+
+    /// @brief Reaction of pending operations to one of their devices failing, i.e. crashing or entering Error state
+    enum class DeviceFailurePolicy
+    {
+        FailFast, ///< fail the operation right away, unless it completes on a quorum which is still reachable
+        Exclude,  ///< stop waiting for the failed device, the operation completes with ErrorCode::DevicesExcluded
+                  ///< unless it completes on a quorum
+        Wait      ///< keep waiting, until the timeout of the operation at the latest
+    };
+
+    /// @brief State change of a single device, as delivered to state change observers
+    struct DeviceStateChange
+    {
+        DDSTask::Id taskId;
+        DeviceState lastState; ///< state before the first change since the previous delivery
+        DeviceState state;
+        std::chrono::system_clock::time_point timestamp; ///< reception of the latest change
+    };
+    using StateChangeHandler = std::function<void(const std::vector<DeviceStateChange>&)>;
+    using StateObserverId = std::size_t;
+
+    /// @brief Latencies of the devices of a change state operation, from its initiation until a device entered the
+    /// target state
+    struct TransitionLatencyStats
+    {
+        struct Device
+        {
+            DDSTask::Id taskId;
+            std::chrono::microseconds latency; ///< time until the completion of the operation, if not reached
+            bool reached;
+        };
+
+        std::string transition; ///< transitions of the operation, or the state the devices walked to
+        std::size_t reached = 0; ///< devices which entered the target state during the operation
+        std::size_t pending = 0; ///< devices which had not entered it when the operation completed
+        std::chrono::microseconds p50{ 0 };
+        std::chrono::microseconds p95{ 0 };
+        std::chrono::microseconds p99{ 0 };
+        std::chrono::microseconds max{ 0 };
+        std::vector<Device> slowest; ///< pending devices first, then the slowest ones which reached the target state
+    };
+
+    /// @brief Progress report of a pending topology operation
+    struct OperationProgress
+    {
+        std::size_t done;                          ///< devices which reached the target state, or replied
+        std::size_t total;                         ///< devices covered by the operation
+        std::map<DeviceState, std::size_t> states; ///< number of covered devices per current state
+    };
+
+    /// @brief Optional progress reporting of a topology operation
+    ///
+    /// Reports are rate-limited to one per interval, updates in between are coalesced into the next report. Reports
+    /// are posted to the executor of the topology and may race with the completion handler.
+    struct ProgressOptions
+    {
+        std::function<void(const OperationProgress&)> handler; ///< empty disables progress reports
+        std::chrono::milliseconds interval = std::chrono::milliseconds(100);
+        /// change state operations only: invoked once with the latencies of this operation when it completes, before
+        /// the completion handler. Runs under the lock of the topology, it must not call back into the topology.
+        std::function<void(const TransitionLatencyStats&)> latencyHandler;
+        std::size_t latencyTopK = 10; ///< maximum number of devices in TransitionLatencyStats::slowest
+    };
+
     using FairMQTopologyState = std::vector<DeviceStatus>;
     using FairMQTopologyStateIndex = std::unordered_map<DDSTask::Id, int>; //  task id -> index in the data vector
     using FairMQTopologyStateByTask = std::unordered_map<DDSTask::Id, DeviceStatus>;
     using FairMQTopologyStateByCollection = std::unordered_map<DDSCollection::Id, std::vector<DeviceStatus>>;
     using TopologyTransition = fair::mq::Transition;
 
+    /// Immutable view of the device states of a topology, tagged with the version of the state table it was taken at
+    struct FairMQTopologyStateSnapshot
+    {
+        std::uint64_t version;
+        FairMQTopologyState state;
+    };
+    using FairMQTopologyStateSnapshotPtr = std::shared_ptr<const FairMQTopologyStateSnapshot>;
+
     inline AggregatedTopologyState AggregateState(const FairMQTopologyState& topologyState)
     {
         DeviceState first = topologyState.begin()->state;
@@ -276,6 +391,288 @@ namespace odc::core
         return state;
     }
 
+    /**
+     * @brief Structure-of-arrays layout of the device states of a topology, one entry per dense state index
+     *
+     * Hot loops mostly read the current state only, which is kept as a contiguous byte per device.
+     */
+    struct DeviceStateColumns
+    {
+        std::vector<std::uint8_t> state;
+        std::vector<std::uint8_t> lastState;
+        std::vector<DDSTask::Id> taskId;
+        std::vector<DDSCollection::Id> collectionId;
+        std::vector<int> exitCode;
+        std::vector<int> signal;
+        std::vector<std::uint8_t> subscribed; ///< not std::vector<bool>, neighbouring entries are written concurrently
+        std::vector<std::int64_t> stateEntered; ///< steady clock time the current state was entered at, in us
+
+        using Clock = std::chrono::steady_clock;
+
+        auto Size() const -> std::size_t
+        {
+            return state.size();
+        }
+
+        auto GetState(std::size_t index) const -> DeviceState
+        {
+            return static_cast<DeviceState>(state[index]);
+        }
+
+        auto GetLastState(std::size_t index) const -> DeviceState
+        {
+            return static_cast<DeviceState>(lastState[index]);
+        }
+
+        auto GetStateEntered(std::size_t index) const -> Clock::time_point
+        {
+            return Clock::time_point(std::chrono::microseconds(stateEntered[index]));
+        }
+
+        auto Get(std::size_t index) const -> DeviceStatus
+        {
+            return DeviceStatus{ subscribed[index] != 0,
+                                 GetLastState(index),
+                                 GetState(index),
+                                 taskId[index],
+                                 collectionId[index],
+                                 exitCode[index],
+                                 signal[index] };
+        }
+
+        auto Set(std::size_t index, const DeviceStatus& status) -> void
+        {
+            subscribed[index] = status.subscribed_to_state_changes;
+            lastState[index] = static_cast<std::uint8_t>(status.lastState);
+            state[index] = static_cast<std::uint8_t>(status.state);
+            taskId[index] = status.taskId;
+            collectionId[index] = status.collectionId;
+            exitCode[index] = status.exitCode;
+            signal[index] = status.signal;
+        }
+
+        auto Append(const DeviceStatus& status) -> void
+        {
+            subscribed.push_back(status.subscribed_to_state_changes);
+            lastState.push_back(static_cast<std::uint8_t>(status.lastState));
+            state.push_back(static_cast<std::uint8_t>(status.state));
+            taskId.push_back(status.taskId);
+            collectionId.push_back(status.collectionId);
+            exitCode.push_back(status.exitCode);
+            signal.push_back(status.signal);
+            stateEntered.push_back(Now());
+        }
+
+        /// @brief Current steady clock time in the unit of the stateEntered column
+        static auto Now() -> std::int64_t
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count();
+        }
+
+        /// @brief Set over the state indices of the devices whose entry in the state or lastState column equals state
+        static auto EqualSet(const std::vector<std::uint8_t>& column, DeviceState state)
+            -> boost::dynamic_bitset<std::uint64_t>
+        {
+            std::vector<std::uint64_t> words((column.size() + 63) / 64);
+            StatesEqualMask(column.data(), column.size(), static_cast<std::uint8_t>(state), words.data());
+            boost::dynamic_bitset<std::uint64_t> set(words.cbegin(), words.cend());
+            set.resize(column.size());
+            return set;
+        }
+
+        /// @brief Conversion to the array-of-structs FairMQTopologyState of the public API
+        auto ToTopologyState() const -> FairMQTopologyState
+        {
+            FairMQTopologyState result;
+            result.reserve(Size());
+            for (std::size_t i = 0; i < Size(); ++i)
+            {
+                result.push_back(Get(i));
+            }
+            return result;
+        }
+    };
+
+    /**
+     * @brief Device state table of a topology, striped into shards of contiguous state indices
+     *
+     * Every shard has its own lock, so concurrent updates of devices living in different shards do not contend.
+     * Whole table reads lock all shards in ascending order and thus observe a consistent state.
+     * A histogram of device counts per state and the time each device entered its current state are maintained on
+     * every modification.
+     */
+    class DeviceStateTable
+    {
+      public:
+        DeviceStateTable() = default;
+        explicit DeviceStateTable(const FairMQTopologyState& data)
+            : fShards((data.size() + fShardSize - 1) / fShardSize)
+        {
+            for (const auto& status : data)
+            {
+                fColumns.Append(status);
+            }
+            std::array<std::size_t, fNumDeviceStates> counts{};
+            CountStates(fColumns.state.data(), fColumns.Size(), counts.data(), counts.size());
+            for (std::size_t i = 0; i < counts.size(); ++i)
+            {
+                fSummary->fStateCounts[i] = counts[i];
+            }
+        }
+
+        auto Size() const -> std::size_t
+        {
+            return fColumns.Size();
+        }
+
+        /// @brief Apply a modification to a single device status under its shard lock
+        /// @param index dense state index of the device
+        /// @param func callable taking DeviceStatus&, its result is returned
+        template <typename Func>
+        auto Modify(std::size_t index, Func&& func)
+        {
+            std::lock_guard<std::mutex> lk(fShards.at(index / fShardSize).fMtx);
+            fSummary->fVersion.fetch_add(1);
+            DeviceStatus status = fColumns.Get(index);
+            DeviceState const before = status.state;
+            if constexpr (std::is_void_v<decltype(func(status))>)
+            {
+                func(status);
+                fColumns.Set(index, status);
+                CountTransition(index, before, status.state);
+            }
+            else
+            {
+                auto result = func(status);
+                fColumns.Set(index, status);
+                CountTransition(index, before, status.state);
+                return result;
+            }
+        }
+
+        /// @brief Number of devices currently in the given state, O(1)
+        auto GetStateCount(DeviceState state) const -> std::size_t
+        {
+            return fSummary->fStateCounts.at(static_cast<std::size_t>(state)).load();
+        }
+
+        /// @brief Aggregated state of all devices, O(1) in the number of devices
+        auto AggregateState() const -> AggregatedTopologyState
+        {
+            if (Size() == 0)
+            {
+                return AggregatedTopologyState::Undefined;
+            }
+            for (std::size_t i = 0; i < fSummary->fStateCounts.size(); ++i)
+            {
+                if (fSummary->fStateCounts[i].load() == Size())
+                {
+                    return static_cast<AggregatedTopologyState>(i);
+                }
+            }
+            return AggregatedTopologyState::Mixed;
+        }
+
+        auto Get(std::size_t index) const -> DeviceStatus
+        {
+            std::lock_guard<std::mutex> lk(fShards.at(index / fShardSize).fMtx);
+            return fColumns.Get(index);
+        }
+
+        /// @brief Time the device has entered its current state at, its creation time if it has not changed since
+        auto GetStateEntered(std::size_t index) const -> DeviceStateColumns::Clock::time_point
+        {
+            std::lock_guard<std::mutex> lk(fShards.at(index / fShardSize).fMtx);
+            return fColumns.GetStateEntered(index);
+        }
+
+        /// @brief Read the whole table with all shards locked
+        /// @param func callable taking const DeviceStateColumns&, its result is returned
+        template <typename Func>
+        auto Read(Func&& func) const
+        {
+            std::vector<std::unique_lock<std::mutex>> locks;
+            locks.reserve(fShards.size());
+            for (auto& shard : fShards)
+            {
+                locks.emplace_back(shard.fMtx);
+            }
+            return func(static_cast<const DeviceStateColumns&>(fColumns));
+        }
+
+        auto Copy() const -> FairMQTopologyState
+        {
+            return Read([](const DeviceStateColumns& columns) { return columns.ToTopologyState(); });
+        }
+
+        /// @brief Shared immutable snapshot of the table
+        ///
+        /// The snapshot is published read-copy-update style: as long as no device entry was modified, all readers
+        /// share the same snapshot without copying or locking the shards. The first reader after a modification
+        /// builds and publishes the next version.
+        auto Snapshot() const -> FairMQTopologyStateSnapshotPtr
+        {
+            auto snapshot = std::atomic_load(&fSummary->fLatest);
+            if (snapshot && snapshot->version == fSummary->fVersion.load())
+            {
+                return snapshot;
+            }
+
+            std::lock_guard<std::mutex> lk(fSummary->fMtx);
+            // another reader may have published the current version in the meantime
+            snapshot = std::atomic_load(&fSummary->fLatest);
+            if (snapshot && snapshot->version == fSummary->fVersion.load())
+            {
+                return snapshot;
+            }
+            snapshot = Read(
+                [&](const DeviceStateColumns& columns)
+                {
+                    return std::make_shared<const FairMQTopologyStateSnapshot>(
+                        FairMQTopologyStateSnapshot{ fSummary->fVersion.load(), columns.ToTopologyState() });
+                });
+            std::atomic_store(&fSummary->fLatest, snapshot);
+            return snapshot;
+        }
+
+      private:
+        static constexpr std::size_t fShardSize = 128;
+        /// AggregatedTopologyState::Mixed directly follows the last DeviceState
+        static constexpr std::size_t fNumDeviceStates = static_cast<std::size_t>(AggregatedTopologyState::Mixed);
+        static_assert(fNumDeviceStates <= 256, "device states are stored as one byte");
+
+        struct alignas(64) Shard
+        {
+            mutable std::mutex fMtx;
+        };
+
+        /// bookkeeping shared by all shards, kept behind a pointer to keep the table movable
+        struct Summary
+        {
+            std::mutex fMtx;                          ///< serializes snapshot rebuilds
+            std::atomic<std::uint64_t> fVersion{ 0 }; ///< incremented on every modification, under the shard lock
+            FairMQTopologyStateSnapshotPtr fLatest;   ///< accessed with std::atomic_load/std::atomic_store
+            std::array<std::atomic<std::size_t>, fNumDeviceStates> fStateCounts{};
+        };
+
+        DeviceStateColumns fColumns;
+        std::vector<Shard> fShards;
+        std::unique_ptr<Summary> fSummary = std::make_unique<Summary>();
+
+        /// increment before decrement, so that a concurrent reader never sees a state count equal to the total
+        /// which was not there before or after the transition
+        /// precondition: the shard lock of index is held.
+        auto CountTransition(std::size_t index, DeviceState before, DeviceState after) -> void
+        {
+            if (before != after)
+            {
+                fColumns.stateEntered[index] = DeviceStateColumns::Now();
+                ++fSummary->fStateCounts.at(static_cast<std::size_t>(after));
+                --fSummary->fStateCounts.at(static_cast<std::size_t>(before));
+            }
+        }
+    };
+
     /**
      * @class BasicTopology Topology.h <fairmq/sdk/Topology.h>
      * @tparam Executor Associated I/O executor
@@ -290,31 +687,23 @@ namespace odc::core
     class BasicTopology : public AsioBase<Executor, Allocator>
     {
       public:
+        /// @brief Tasks selected by path
+        /// @param path Select a subset of FairMQ devices in this topology, empty selects all
+        /// @return resolved from the per-topology selection cache after the first call with the same path
         auto GetTasks(const std::string& path = "") const -> std::vector<DDSTask>
         {
-            std::vector<DDSTask> list;
-
-            dds::topology_api::STopoRuntimeTask::FilterIteratorPair_t itPair;
-            if (path.empty())
-            {
-                itPair = fDDSTopo.getRuntimeTaskIterator(nullptr); // passing nullptr will get all tasks
-            }
-            else
-            {
-                itPair = fDDSTopo.getRuntimeTaskIteratorMatchingPath(path);
-            }
-            auto tasks = boost::make_iterator_range(itPair.first, itPair.second);
+            return GetTaskSelection(path)->tasks;
+        }
 
-            for (const auto& task : tasks)
-            {
-                // LOG(debug) << "Found task with id: " << task.first << ", "
-                //            << "Path: " << task.second.m_taskPath << ", "
-                //            << "Collection id: " << task.second.m_taskCollectionId << ", "
-                //            << "Name: " << task.second.m_task->getName() << "_" << task.second.m_taskIndex;
-                list.emplace_back(task.first, task.second.m_taskCollectionId);
-            }
+        /// ECS sends the same few paths over and over, the selection cache is only cleared once it holds that many
+        /// paths, as a safety net against unbounded growth
+        static constexpr std::size_t fMaxCachedSelections = 1024;
 
-            return list;
+        /// @brief Number of paths currently in the selection cache
+        auto GetNumCachedSelections() const -> std::size_t
+        {
+            std::lock_guard<std::mutex> lk(*fSelectionsMtx);
+            return fSelections.size();
         }
 
         /// @brief (Re)Construct a FairMQ topology from an existing DDS topology
@@ -349,6 +738,8 @@ namespace odc::core
             , fNumStateChangePublishers(0)
             , fHeartbeatsTimer(boost::asio::system_executor())
             , fHeartbeatInterval(600000)
+            , fTimers(std::make_shared<TimerWheel>(ex))
+            , fDeviceFailurePolicy(DeviceFailurePolicy::FailFast)
         {
             makeTopologyState();
 
@@ -359,6 +750,8 @@ namespace odc::core
             // throw RuntimeError("Given topology ", givenTopo, " is not activated (active: ", activeTopo, ")");
             // }
 
+            fIngress = std::make_unique<CommandIngress>([this](std::vector<CommandIngress::Item>& batch)
+                                                        { HandleCommands(batch); });
             SubscribeToCommands();
             SubscribeToTaskDoneEvents();
 
@@ -374,16 +767,24 @@ namespace odc::core
         BasicTopology(const BasicTopology&) = delete;
         BasicTopology& operator=(const BasicTopology&) = delete;
 
-        /// movable
-        BasicTopology(BasicTopology&&) = default;
-        BasicTopology& operator=(BasicTopology&&) = default;
+        /// not movable, pending operations, progress reporters and the command ingress refer to this object and its
+        /// state table
+        BasicTopology(BasicTopology&&) = delete;
+        BasicTopology& operator=(BasicTopology&&) = delete;
 
         ~BasicTopology()
         {
+            fTimers->CancelAll();
             UnsubscribeFromStateChanges();
+            // the unsubscription confirmations above arrive through the ingress, stop it only afterwards
+            fDDSCustomCmd.unsubscribe();
+            fIngress->Stop();
 
             std::lock_guard<std::mutex> lk(*fMtx);
-            fDDSCustomCmd.unsubscribe();
+            for (auto& entry : fStateObservers)
+            {
+                entry.second->Deactivate();
+            }
             try
             {
                 for (auto& op : fChangeStateOps)
@@ -399,8 +800,7 @@ namespace odc::core
         void SubscribeToStateChanges()
         {
             // FAIR_LOG(debug) << "Subscribing to state change";
-            cc::Cmds cmds(cc::make<cc::SubscribeToStateChange>(fHeartbeatInterval.count()));
-            fDDSCustomCmd.send(cmds.Serialize(), "");
+            fDDSCustomCmd.send(cc::EncodedCmds::SubscribeToStateChange(fHeartbeatInterval.count()), "");
 
             fHeartbeatsTimer.expires_after(fHeartbeatInterval);
             fHeartbeatsTimer.async_wait(
@@ -415,17 +815,41 @@ namespace odc::core
             requestPtr->setResponseCallback(
                 [&](const SOnTaskDoneResponseData& _info)
                 {
-                    std::unique_lock<std::mutex> lk(*fMtx);
-                    DeviceStatus& task = fStateData.at(fStateIndex.at(_info.m_taskID));
-                    if (task.subscribed_to_state_changes)
+                    auto const index = fStateIndex.at(_info.m_taskID);
+                    DeviceState lastState = DeviceState::Undefined;
+                    bool const wasSubscribed = fStateTable.Modify(index,
+                                                                  [&](DeviceStatus& task)
+                                                                  {
+                                                                      bool const subscribed =
+                                                                          task.subscribed_to_state_changes;
+                                                                      task.subscribed_to_state_changes = false;
+                                                                      task.exitCode = _info.m_exitCode;
+                                                                      task.signal = _info.m_signal;
+                                                                      task.lastState = task.state;
+                                                                      task.state = DeviceState::Error;
+                                                                      lastState = task.lastState;
+                                                                      return subscribed;
+                                                                  });
+                    std::lock_guard<std::mutex> lk(*fMtx);
+                    if (wasSubscribed)
                     {
-                        task.subscribed_to_state_changes = false;
                         --fNumStateChangePublishers;
                     }
-                    task.exitCode = _info.m_exitCode;
-                    task.signal = _info.m_signal;
-                    task.lastState = task.state;
-                    task.state = DeviceState::Error;
+                    NotifyStateObservers(index, { _info.m_taskID, lastState, DeviceState::Error, {} });
+                    if (lastState != DeviceState::Exiting)
+                    {
+                        OLOG(ESeverity::warning)
+                            << "Task " << _info.m_taskID << " exited unexpectedly in " << lastState
+                            << " state (exit code: " << _info.m_exitCode << ", signal: " << _info.m_signal << ")";
+                        auto const& waitForStateOps = fWaitForStateOpsByTask.at(index);
+                        for (auto i = waitForStateOps.size(); i-- > 0;)
+                        {
+                            auto it = fWaitForStateOps.find(waitForStateOps[i]);
+                            it->second.Update(index, lastState, DeviceState::Error);
+                            RetireIfCompleted(fWaitForStateOps, it);
+                        }
+                        OnDeviceFailed(index);
+                    }
                 });
             fDDSSession->sendRequest<SOnTaskDoneRequest>(requestPtr);
         }
@@ -450,8 +874,7 @@ namespace odc::core
             if (!ec)
             {
                 // Timer expired.
-                fDDSCustomCmd.send(
-                    cc::Cmds(cc::make<cc::SubscriptionHeartbeat>(fHeartbeatInterval.count())).Serialize(), "");
+                fDDSCustomCmd.send(cc::EncodedCmds::SubscriptionHeartbeat(fHeartbeatInterval.count()), "");
                 // schedule again
                 fHeartbeatsTimer.expires_after(fHeartbeatInterval);
                 fHeartbeatsTimer.async_wait(
@@ -473,7 +896,7 @@ namespace odc::core
             fHeartbeatsTimer.cancel();
 
             // unsubscribe from state changes
-            fDDSCustomCmd.send(cc::Cmds(cc::make<cc::UnsubscribeFromStateChange>()).Serialize(), "");
+            fDDSCustomCmd.send(cc::EncodedCmds::UnsubscribeFromStateChange(), "");
 
             // wait for all tasks to confirm unsubscription
             WaitForPublisherCount(0);
@@ -481,44 +904,142 @@ namespace odc::core
 
         void SubscribeToCommands()
         {
+            // The DDS callback thread only enqueues, decoding and dispatching happens on the ingress thread.
             fDDSCustomCmd.subscribe(
                 [&](const std::string& msg, const std::string& /* condition */, DDSChannel::Id senderId)
+                { fIngress->Push(msg, senderId); });
+        }
+
+        /// Decode a batch of incoming messages and dispatch their commands in order. Runs of state changes, the bulk
+        /// of the traffic, are coalesced per task to the latest (last, current) pair and applied under a single
+        /// acquisition of fMtx. Error states are never coalesced away, the failure handling relies on them, and
+        /// neither are states a pending operation covering the task waits for, e.g. a step of a transition sequence.
+        /// State changes of tasks which have exited in the meantime are dropped by ApplyStateChange.
+        /// State changes, also those packed into state change batches, and successful transition statuses are read in
+        /// place from the received buffers, only the remaining commands are copied out.
+        auto HandleCommands(std::vector<CommandIngress::Item>& batch) -> void
+        {
+            std::vector<std::pair<cc::CmdsView, DDSChannel::Id>> decoded;
+            decoded.reserve(batch.size());
+            for (auto& item : batch)
+            {
+                try
+                {
+                    decoded.emplace_back(cc::CmdsView(item.msg), item.senderId);
+                }
+                catch (const std::exception& e)
+                {
+                    OLOG(ESeverity::error) << "Failed to decode commands from " << item.senderId << ": " << e.what();
+                }
+            }
+
+            struct PendingStateChange
+            {
+                DDSTask::Id taskId;
+                DeviceState lastState;
+                DeviceState currentState;
+                DDSChannel::Id senderId;
+            };
+            std::vector<PendingStateChange> stateChanges;
+            std::unordered_map<DDSTask::Id, std::size_t> latestByTask; ///< task id -> position in stateChanges
+            auto addStateChange = [&](PendingStateChange stateChange)
+            {
+                latestByTask[stateChange.taskId] = stateChanges.size();
+                stateChanges.push_back(stateChange);
+            };
+            auto applyStateChanges = [&]()
+            {
+                if (stateChanges.empty())
+                {
+                    return;
+                }
+                std::lock_guard<std::mutex> lk(*fMtx);
+                for (std::size_t i = 0; i < stateChanges.size(); ++i)
                 {
-                    cc::Cmds inCmds;
-                    inCmds.Deserialize(msg);
-                    // OLOG(ESeverity::debug) << "Received " << inCmds.Size() << " command(s) with total size of " <<
-                    // msg.length() << " bytes: ";
+                    auto const& stateChange = stateChanges[i];
+                    // whether an operation waits for an earlier state is only known once the ones before are applied
+                    if (latestByTask.at(stateChange.taskId) == i || stateChange.currentState == DeviceState::Error ||
+                        IsAwaited(stateChange.taskId, stateChange.lastState, stateChange.currentState))
+                    {
+                        ApplyStateChange(stateChange.taskId,
+                                         stateChange.lastState,
+                                         stateChange.currentState,
+                                         stateChange.senderId);
+                    }
+                }
+                stateChanges.clear();
+                latestByTask.clear();
+            };
 
-                    for (const auto& cmd : inCmds)
+            for (auto const& [inCmds, senderId] : decoded)
+            {
+                for (auto const view : inCmds)
+                {
+                    try
                     {
-                        // OLOG(ESeverity::debug) << " > " << cmd->GetType();
-                        switch (cmd->GetType())
+                        auto const type = view.GetType();
+                        if (type == cc::Type::state_change)
+                        {
+                            addStateChange(
+                                { view.GetTaskId(), view.GetLastState(), view.GetCurrentState(), senderId });
+                            continue;
+                        }
+                        if (type == cc::Type::state_change_batch)
+                        {
+                            // the exiting acknowledgement of every entry goes to the sender of the batch
+                            for (std::size_t i = 0; i < view.GetNumStateChanges(); ++i)
+                            {
+                                auto const e = view.GetStateChange(i);
+                                addStateChange({ e.taskId, e.lastState, e.currentState, senderId });
+                            }
+                            continue;
+                        }
+
+                        applyStateChanges();
+                        if (type == cc::Type::transition_status && view.GetResult() == cc::Result::Ok)
                         {
-                            case cc::Type::state_change_subscription:
-                                HandleCmd(static_cast<cc::StateChangeSubscription&>(*cmd));
-                                break;
-                            case cc::Type::state_change_unsubscription:
-                                HandleCmd(static_cast<cc::StateChangeUnsubscription&>(*cmd));
-                                break;
-                            case cc::Type::state_change:
-                                HandleCmd(static_cast<cc::StateChange&>(*cmd), senderId);
-                                break;
-                            case cc::Type::transition_status:
-                                HandleCmd(static_cast<cc::TransitionStatus&>(*cmd));
-                                break;
-                            case cc::Type::properties:
-                                HandleCmd(static_cast<cc::Properties&>(*cmd));
-                                break;
-                            case cc::Type::properties_set:
-                                HandleCmd(static_cast<cc::PropertiesSet&>(*cmd));
-                                break;
-                            default:
-                                OLOG(ESeverity::warning) << "Unexpected/unknown command received: " << cmd->GetType();
-                                OLOG(ESeverity::warning) << "Origin: " << senderId;
-                                break;
+                            // nothing to do for successful transitions, their outcome arrives as state changes
+                            continue;
                         }
+                        HandleCmd(*view.ToCmd(), senderId);
                     }
-                });
+                    catch (const std::exception& e)
+                    {
+                        OLOG(ESeverity::error) << "Failed to handle command from " << senderId << ": " << e.what();
+                    }
+                }
+            }
+            applyStateChanges();
+        }
+
+        auto HandleCmd(cc::Cmd& cmd, DDSChannel::Id const& senderId) -> void
+        {
+            // OLOG(ESeverity::debug) << " > " << cmd.GetType();
+            switch (cmd.GetType())
+            {
+                case cc::Type::state_change_subscription:
+                    HandleCmd(static_cast<cc::StateChangeSubscription&>(cmd));
+                    break;
+                case cc::Type::state_change_unsubscription:
+                    HandleCmd(static_cast<cc::StateChangeUnsubscription&>(cmd));
+                    break;
+                case cc::Type::state_change:
+                    HandleCmd(static_cast<cc::StateChange&>(cmd), senderId);
+                    break;
+                case cc::Type::transition_status:
+                    HandleCmd(static_cast<cc::TransitionStatus&>(cmd));
+                    break;
+                case cc::Type::properties:
+                    HandleCmd(static_cast<cc::Properties&>(cmd));
+                    break;
+                case cc::Type::properties_set:
+                    HandleCmd(static_cast<cc::PropertiesSet&>(cmd));
+                    break;
+                default:
+                    OLOG(ESeverity::warning) << "Unexpected/unknown command received: " << cmd.GetType();
+                    OLOG(ESeverity::warning) << "Origin: " << senderId;
+                    break;
+            }
         }
 
         auto HandleCmd(cc::StateChangeSubscription const& cmd) -> void
@@ -530,16 +1051,22 @@ namespace odc::core
                 try
                 {
                     std::unique_lock<std::mutex> lk(*fMtx);
-                    DeviceStatus& task = fStateData.at(fStateIndex.at(taskId));
-                    if (!task.subscribed_to_state_changes)
+                    bool const wasSubscribed = fStateTable.Modify(fStateIndex.at(taskId),
+                                                                  [](DeviceStatus& task)
+                                                                  {
+                                                                      bool const subscribed =
+                                                                          task.subscribed_to_state_changes;
+                                                                      task.subscribed_to_state_changes = true;
+                                                                      return subscribed;
+                                                                  });
+                    if (!wasSubscribed)
                     {
-                        task.subscribed_to_state_changes = true;
                         ++fNumStateChangePublishers;
                     }
                     else
                     {
                         OLOG(ESeverity::warning)
-                            << "Task '" << task.taskId << "' sent subscription confirmation more than once";
+                            << "Task '" << taskId << "' sent subscription confirmation more than once";
                     }
                     lk.unlock();
                     fStateChangeSubscriptionsCV->notify_one();
@@ -567,16 +1094,22 @@ namespace odc::core
                 try
                 {
                     std::unique_lock<std::mutex> lk(*fMtx);
-                    DeviceStatus& task = fStateData.at(fStateIndex.at(taskId));
-                    if (task.subscribed_to_state_changes)
+                    bool const wasSubscribed = fStateTable.Modify(fStateIndex.at(taskId),
+                                                                  [](DeviceStatus& task)
+                                                                  {
+                                                                      bool const subscribed =
+                                                                          task.subscribed_to_state_changes;
+                                                                      task.subscribed_to_state_changes = false;
+                                                                      return subscribed;
+                                                                  });
+                    if (wasSubscribed)
                     {
-                        task.subscribed_to_state_changes = false;
                         --fNumStateChangePublishers;
                     }
                     else
                     {
                         OLOG(ESeverity::warning)
-                            << "Task '" << task.taskId << "' sent unsubscription confirmation more than once";
+                            << "Task '" << taskId << "' sent unsubscription confirmation more than once";
                     }
                     lk.unlock();
                     fStateChangeSubscriptionsCV->notify_one();
@@ -596,40 +1129,88 @@ namespace odc::core
 
         auto HandleCmd(cc::StateChange const& cmd, DDSChannel::Id const& senderId) -> void
         {
-            if (cmd.GetCurrentState() == DeviceState::Exiting)
+            std::lock_guard<std::mutex> lk(*fMtx);
+            ApplyStateChange(cmd.GetTaskId(), cmd.GetLastState(), cmd.GetCurrentState(), senderId);
+        }
+
+        /// precondition: fMtx is locked.
+        auto ApplyStateChange(DDSTask::Id const taskId,
+                              DeviceState const lastState,
+                              DeviceState const currentState,
+                              DDSChannel::Id const& senderId) -> void
+        {
+            if (currentState == DeviceState::Exiting)
             {
-                fDDSCustomCmd.send(cc::Cmds(cc::make<cc::StateChangeExitingReceived>()).Serialize(),
-                                   std::to_string(senderId));
+                fDDSCustomCmd.send(cc::EncodedCmds::StateChangeExitingReceived(), std::to_string(senderId));
             }
 
-            DDSTask::Id taskId(cmd.GetTaskId());
-
             try
             {
-                std::lock_guard<std::mutex> lk(*fMtx);
-                DeviceStatus& task = fStateData.at(fStateIndex.at(taskId));
-                task.lastState = cmd.GetLastState();
-                task.state = cmd.GetCurrentState();
-                // if the task is exiting, it will not respond to unsubscription request anymore, set it to false now.
-                if (task.state == DeviceState::Exiting)
+                // fStateIndex is immutable after construction, the device entry is protected by its shard lock
+                auto const index = fStateIndex.at(taskId);
+                bool exited = false;
+                auto update = [&](DeviceStatus& task)
                 {
-                    task.subscribed_to_state_changes = false;
-                    --fNumStateChangePublishers;
+                    bool const subscribed = task.subscribed_to_state_changes;
+                    // The task done event does not go through the ingress, state changes the task has sent before
+                    // exiting may arrive afterwards. The state of an exited task is final.
+                    if (task.exitCode != -1 || task.signal != -1)
+                    {
+                        exited = true;
+                        return subscribed;
+                    }
+                    task.lastState = lastState;
+                    task.state = currentState;
+                    // if the task is exiting, it will not respond to unsubscription request anymore, set it to false now.
+                    if (task.state == DeviceState::Exiting)
+                    {
+                        task.subscribed_to_state_changes = false;
+                    }
+                    return subscribed;
+                };
+                bool const wasSubscribed = fStateTable.Modify(index, update);
+                if (exited)
+                {
+                    OLOG(ESeverity::debug) << "Ignoring state change to " << currentState << " of exited task "
+                                           << taskId;
+                    return;
                 }
                 // FAIR_LOG(debug) << "Updated state entry: taskId=" << taskId << ", state=" << state;
 
-                for (auto& op : fChangeStateOps)
+                if (currentState == DeviceState::Exiting && wasSubscribed)
+                {
+                    --fNumStateChangePublishers;
+                }
+                NotifyStateObservers(index, { taskId, lastState, currentState, {} });
+
+                // Only visit the ops that cover this task. Iterate backwards, retiring an op moves an already visited
+                // id into its place.
+                auto const& changeStateOps = fChangeStateOpsByTask.at(index);
+                for (auto i = changeStateOps.size(); i-- > 0;)
+                {
+                    auto it = fChangeStateOps.find(changeStateOps[i]);
+                    if (auto const next = it->second.Update(index, currentState))
+                    {
+                        // next step of a transition sequence, only for this device
+                        fDDSCustomCmd.send(cc::EncodedCmds::ChangeState(*next), std::to_string(senderId));
+                    }
+                    RetireIfCompleted(fChangeStateOps, it);
+                }
+                auto const& waitForStateOps = fWaitForStateOpsByTask.at(index);
+                for (auto i = waitForStateOps.size(); i-- > 0;)
                 {
-                    op.second.Update(taskId, cmd.GetCurrentState());
+                    auto it = fWaitForStateOps.find(waitForStateOps[i]);
+                    it->second.Update(index, lastState, currentState);
+                    RetireIfCompleted(fWaitForStateOps, it);
                 }
-                for (auto& op : fWaitForStateOps)
+                if (currentState == DeviceState::Error)
                 {
-                    op.second.Update(taskId, cmd.GetLastState(), cmd.GetCurrentState());
+                    OnDeviceFailed(index);
                 }
             }
             catch (const std::exception& e)
             {
-                OLOG(ESeverity::error) << "Exception in HandleCmd(cmd::StateChange const&): " << e.what();
+                OLOG(ESeverity::error) << "Exception in ApplyStateChange(): " << e.what();
             }
         }
 
@@ -639,16 +1220,20 @@ namespace odc::core
             {
                 DDSTask::Id taskId(cmd.GetTaskId());
                 std::lock_guard<std::mutex> lk(*fMtx);
-                for (auto& op : fChangeStateOps)
+                auto const index = fStateIndex.at(taskId);
+                auto const& changeStateOps = fChangeStateOpsByTask.at(index);
+                for (auto i = changeStateOps.size(); i-- > 0;)
                 {
-                    if (!op.second.IsCompleted() && op.second.ContainsTask(taskId))
+                    auto it = fChangeStateOps.find(changeStateOps[i]);
+                    auto& op = it->second;
+                    if (!op.IsCompleted())
                     {
-                        if (fStateData.at(fStateIndex.at(taskId)).state != op.second.GetTargetState())
+                        if (fStateTable.Get(index).state != op.GetTargetState(index))
                         {
                             OLOG(ESeverity::error)
                                 << cmd.GetTransition() << " transition failed for " << cmd.GetDeviceId()
                                 << ", device is in " << cmd.GetCurrentState() << " state.";
-                            op.second.Complete(MakeErrorCode(ErrorCode::DeviceChangeStateFailed));
+                            op.Complete(MakeErrorCode(ErrorCode::DeviceChangeStateFailed));
                         }
                         else
                         {
@@ -657,91 +1242,401 @@ namespace odc::core
                                 << ", device is already in " << cmd.GetCurrentState() << " state.";
                         }
                     }
+                    RetireIfCompleted(fChangeStateOps, it);
                 }
             }
         }
 
         auto HandleCmd(cc::Properties const& cmd) -> void
         {
-            std::unique_lock<std::mutex> lk(*fMtx);
-            try
-            {
-                auto& op(fGetPropertiesOps.at(cmd.GetRequestId()));
-                lk.unlock();
-                op.Update(cmd.GetDeviceId(), cmd.GetResult(), cmd.GetProps());
-            }
-            catch (std::out_of_range& e)
+            std::lock_guard<std::mutex> lk(*fMtx);
+            auto it = fGetPropertiesOps.find(cmd.GetRequestId());
+            if (it == fGetPropertiesOps.end())
             {
                 OLOG(ESeverity::debug) << "GetProperties operation (request id: " << cmd.GetRequestId()
                                        << ") not found (probably completed or timed out), "
                                        << "discarding reply of device " << cmd.GetDeviceId();
+                return;
             }
+            it->second.Update(cmd.GetDeviceId(), cmd.GetResult(), cmd.GetProps());
+            RetireIfCompleted(fGetPropertiesOps, it);
         }
 
         auto HandleCmd(cc::PropertiesSet const& cmd) -> void
         {
-            std::unique_lock<std::mutex> lk(*fMtx);
-            try
-            {
-                auto& op(fSetPropertiesOps.at(cmd.GetRequestId()));
-                lk.unlock();
-                op.Update(cmd.GetDeviceId(), cmd.GetResult());
-            }
-            catch (std::out_of_range& e)
+            std::lock_guard<std::mutex> lk(*fMtx);
+            auto it = fSetPropertiesOps.find(cmd.GetRequestId());
+            if (it == fSetPropertiesOps.end())
             {
                 OLOG(ESeverity::debug) << "SetProperties operation (request id: " << cmd.GetRequestId()
                                        << ") not found (probably completed or timed out), "
                                        << "discarding reply of device " << cmd.GetDeviceId();
+                return;
             }
+            it->second.Update(cmd.GetDeviceId(), cmd.GetResult());
+            RetireIfCompleted(fSetPropertiesOps, it);
         }
 
         using Duration = std::chrono::microseconds;
         using ChangeStateCompletionSignature = void(std::error_code, FairMQTopologyState);
+        /// last argument: tasks which have not reached the target state
+        using ChangeStateQuorumCompletionSignature =
+            void(std::error_code, FairMQTopologyState, std::vector<DDSTask::Id>);
 
       private:
-        struct ChangeStateOp
-        {
-            using Id = std::size_t;
-            using Count = unsigned int;
+        /// Set of tasks, one bit per dense state index (see fStateIndex)
+        using TaskSet = boost::dynamic_bitset<std::uint64_t>;
 
-            template <typename Handler>
+        /// Coalescing queue of a state change observer. It holds at most one pending change per device, which bounds
+        /// it by the number of observed devices. One delivery at a time is in flight on the executor.
+        class StateObserver : public std::enable_shared_from_this<StateObserver>
+        {
+          public:
+            StateObserver(TaskSet tasks, StateChangeHandler handler, Executor const& ex)
+                : fTasks(std::move(tasks))
+                , fHandler(std::move(handler))
+                , fEx(ex)
+                , fPendingPos(fTasks.size(), fNone)
+                , fScheduled(false)
+                , fActive(true)
+            {
+            }
+
+            auto Covers(std::size_t index) const -> bool
+            {
+                return fTasks.test(index);
+            }
+
+            auto Push(std::size_t index, const DeviceStateChange& change) -> void
+            {
+                std::lock_guard<std::mutex> lk(fMtx);
+                auto& pos = fPendingPos[index];
+                if (pos == fNone)
+                {
+                    pos = fPending.size();
+                    fPending.push_back(change);
+                    fPendingIndices.push_back(index);
+                }
+                else
+                {
+                    fPending[pos].state = change.state;
+                    fPending[pos].timestamp = change.timestamp;
+                }
+                if (!fScheduled)
+                {
+                    fScheduled = true;
+                    boost::asio::post(fEx, [self = this->shared_from_this()]() { self->Deliver(); });
+                }
+            }
+
+            auto Deactivate() -> void
+            {
+                fActive = false;
+            }
+
+          private:
+            static constexpr std::size_t fNone = std::numeric_limits<std::size_t>::max();
+
+            auto Deliver() -> void
+            {
+                std::vector<DeviceStateChange> changes;
+                {
+                    std::lock_guard<std::mutex> lk(fMtx);
+                    changes.swap(fPending);
+                    for (auto const index : fPendingIndices)
+                    {
+                        fPendingPos[index] = fNone;
+                    }
+                    fPendingIndices.clear();
+                }
+
+                if (fActive)
+                {
+                    try
+                    {
+                        fHandler(changes);
+                    }
+                    catch (const std::exception& e)
+                    {
+                        OLOG(ESeverity::error) << "Exception in state change observer: " << e.what();
+                    }
+                }
+
+                // changes which arrived in the meantime are delivered by the next round
+                std::lock_guard<std::mutex> lk(fMtx);
+                if (fPending.empty() || !fActive)
+                {
+                    fScheduled = false;
+                }
+                else
+                {
+                    boost::asio::post(fEx, [self = this->shared_from_this()]() { self->Deliver(); });
+                }
+            }
+
+            TaskSet const fTasks;
+            StateChangeHandler const fHandler;
+            Executor fEx;
+            std::mutex fMtx;
+            std::vector<DeviceStateChange> fPending;
+            std::vector<std::size_t> fPendingIndices; ///< state index of each entry of fPending
+            std::vector<std::size_t> fPendingPos;     ///< state index -> position in fPending, fNone if none
+            bool fScheduled;                          ///< a delivery is posted or running
+            std::atomic<bool> fActive;
+        };
+
+        /// Rate-limited progress reports of an operation. Updates arriving within the interval are coalesced into a
+        /// single report, which is computed once it is due.
+        class ProgressReporter
+        {
+          public:
+            ProgressReporter(ProgressOptions options,
+                             TaskSet tasks,
+                             const DeviceStateTable& stateTable,
+                             TimerWheel& timers,
+                             TimerWheel::Callback onTimer,
+                             Executor const& ex)
+                : fHandler(std::move(options.handler))
+                , fInterval(options.interval)
+                , fTasks(std::move(tasks))
+                , fStateTable(stateTable)
+                , fTimers(timers)
+                , fOnTimer(std::move(onTimer))
+                , fTimer(0)
+                , fEx(ex)
+                , fDone(0)
+            {
+            }
+            ProgressReporter(const ProgressReporter&) = delete;
+            ProgressReporter& operator=(const ProgressReporter&) = delete;
+            ~ProgressReporter()
+            {
+                fTimers.Cancel(fTimer);
+            }
+
+            /// precondition: fMtx is locked.
+            auto Notify(std::size_t done) -> void
+            {
+                fDone = done;
+                if (fTimer != 0)
+                {
+                    return; // the deferred report picks up the latest count
+                }
+                auto const now = Clock::now();
+                if (now - fLastReport >= fInterval)
+                {
+                    Report(now);
+                }
+                else
+                {
+                    fTimer = fTimers.Schedule(std::chrono::duration_cast<Duration>(fLastReport + fInterval - now),
+                                              fOnTimer);
+                }
+            }
+
+            /// precondition: fMtx is locked.
+            auto OnTimer() -> void
+            {
+                fTimer = 0;
+                Report(Clock::now());
+            }
+
+          private:
+            using Clock = std::chrono::steady_clock;
+
+            /// precondition: fMtx is locked.
+            auto Report(Clock::time_point now) -> void
+            {
+                fLastReport = now;
+                OperationProgress progress{ fDone, fTasks.count(), {} };
+                fStateTable.Read(
+                    [&](const DeviceStateColumns& columns)
+                    {
+                        for (auto i = fTasks.find_first(); i != TaskSet::npos; i = fTasks.find_next(i))
+                        {
+                            ++progress.states[columns.GetState(i)];
+                        }
+                    });
+                boost::asio::post(fEx,
+                                  [handler = fHandler, progress = std::move(progress)]() { handler(progress); });
+            }
+
+            std::function<void(const OperationProgress&)> const fHandler;
+            std::chrono::milliseconds const fInterval;
+            TaskSet const fTasks;
+            const DeviceStateTable& fStateTable;
+            TimerWheel& fTimers;
+            TimerWheel::Callback const fOnTimer;
+            TimerWheel::Id fTimer; ///< pending deferred report, 0 if none
+            Executor fEx;
+            Clock::time_point fLastReport;
+            std::size_t fDone;
+        };
+
+        /// Raw device latencies of a completed change state operation
+        struct TransitionLatencies
+        {
+            std::string transition;
+            std::vector<TransitionLatencyStats::Device> devices;
+        };
+
+        /// @brief Latency distribution of the devices of a change state operation
+        /// @param topK maximum number of devices in TransitionLatencyStats::slowest
+        static auto MakeTransitionStats(TransitionLatencies latencies, const std::size_t topK)
+            -> TransitionLatencyStats
+        {
+            TransitionLatencyStats stats;
+            stats.transition = std::move(latencies.transition);
+            auto& devices = latencies.devices;
+            // pending devices first, then descending by latency
+            std::sort(devices.begin(),
+                      devices.end(),
+                      [](const auto& a, const auto& b)
+                      { return a.reached != b.reached ? !a.reached : a.latency > b.latency; });
+            auto const firstReached = std::find_if(devices.cbegin(), devices.cend(), [](auto& d) { return d.reached; });
+            stats.pending = std::distance(devices.cbegin(), firstReached);
+            stats.reached = devices.size() - stats.pending;
+            if (stats.reached > 0)
+            {
+                // nearest rank on the descending reached range
+                auto const percentile = [&](double p)
+                {
+                    auto const rank = static_cast<std::size_t>(std::ceil(p * stats.reached));
+                    return firstReached[stats.reached - std::max(rank, std::size_t(1))].latency;
+                };
+                stats.p50 = percentile(0.5);
+                stats.p95 = percentile(0.95);
+                stats.p99 = percentile(0.99);
+                stats.max = firstReached->latency;
+            }
+            devices.resize(std::min(devices.size(), topK));
+            stats.slowest = std::move(devices);
+            return stats;
+        }
+
+        struct ChangeStateOp
+        {
+            using Id = std::size_t;
+
+            template <typename Handler>
             ChangeStateOp(Id id,
-                          const TopologyTransition transition,
-                          std::vector<DDSTask> tasks,
-                          FairMQTopologyState& stateData,
+                          std::vector<TopologyTransition> transitions,
+                          std::vector<DeviceState> targetStates,
+                          TaskSet tasks,
+                          const DeviceStateTable& stateTable,
                           Duration timeout,
+                          TimerWheel& timers,
+                          TimerWheel::Callback onTimeout,
                           std::mutex& mutex,
                           Executor const& ex,
                           Allocator const& alloc,
                           Handler&& handler)
+                : ChangeStateOp(id,
+                                std::move(transitions),
+                                std::move(targetStates),
+                                std::move(tasks),
+                                stateTable,
+                                timeout,
+                                timers,
+                                std::move(onTimeout),
+                                mutex)
+            {
+                fOp = AsioAsyncOp<Executor, Allocator, ChangeStateCompletionSignature>(ex, alloc, std::move(handler));
+            }
+
+            template <typename Handler>
+            ChangeStateOp(Id id,
+                          std::vector<TopologyTransition> transitions,
+                          std::vector<DeviceState> targetStates,
+                          TaskSet tasks,
+                          const DeviceStateTable& stateTable,
+                          Duration timeout,
+                          TimerWheel& timers,
+                          TimerWheel::Callback onTimeout,
+                          std::mutex& mutex,
+                          Executor const& ex,
+                          Allocator const& alloc,
+                          const ChangeStateQuorum& quorum,
+                          Handler&& handler)
+                : ChangeStateOp(id,
+                                std::move(transitions),
+                                std::move(targetStates),
+                                std::move(tasks),
+                                stateTable,
+                                timeout,
+                                timers,
+                                std::move(onTimeout),
+                                mutex)
+            {
+                using QuorumOp = AsioAsyncOp<Executor, Allocator, ChangeStateQuorumCompletionSignature>;
+                fQuorumOp = QuorumOp(ex, alloc, std::move(handler));
+                fQuorum = true;
+                auto const numTasks = fTasks.count();
+                // reaching every device satisfies any criterion
+                fMinReached = numTasks;
+                if (quorum.minDevices > 0)
+                {
+                    fMinReached = std::min(fMinReached, quorum.minDevices);
+                }
+                if (quorum.minFraction > 0.0)
+                {
+                    fMinReached = std::min(fMinReached,
+                                           static_cast<std::size_t>(std::ceil(quorum.minFraction * numTasks)));
+                }
+                fRequired.resize(fTasks.size());
+                for (auto i = fTasks.find_first(); i != TaskSet::npos; i = fTasks.find_next(i))
+                {
+                    auto const collectionId = stateTable.Get(i).collectionId;
+                    if (std::find(quorum.requiredCollections.cbegin(),
+                                  quorum.requiredCollections.cend(),
+                                  collectionId) != quorum.requiredCollections.cend())
+                    {
+                        fRequired.set(i);
+                    }
+                }
+            }
+
+          private:
+            ChangeStateOp(Id id,
+                          std::vector<TopologyTransition> transitions,
+                          std::vector<DeviceState> targetStates,
+                          TaskSet tasks,
+                          const DeviceStateTable& stateTable,
+                          Duration timeout,
+                          TimerWheel& timers,
+                          TimerWheel::Callback onTimeout,
+                          std::mutex& mutex)
                 : fId(id)
-                , fOp(ex, alloc, std::move(handler))
-                , fStateData(stateData)
-                , fTimer(ex)
-                , fCount(0)
+                , fStateTable(stateTable)
+                , fTimers(timers)
+                , fTimer(0)
                 , fTasks(std::move(tasks))
-                , fTargetState(expectedState.at(transition))
+                , fReached(fTasks.size())
+                , fTransitions(std::move(transitions))
+                , fTargetStates(std::move(targetStates))
+                , fQuorum(false)
+                , fMinReached(fTasks.count())
+                , fFailed(fTasks.size())
+                , fLatencyTopK(0)
+                , fStart(DeviceStateColumns::Clock::now())
                 , fMtx(mutex)
             {
+                if (fTargetStates.size() > 1)
+                {
+                    fSteps.resize(fTasks.size(), 0);
+                }
                 if (timeout > std::chrono::milliseconds(0))
                 {
-                    fTimer.expires_after(timeout);
-                    fTimer.async_wait(
-                        [&](std::error_code ec)
-                        {
-                            if (!ec)
-                            {
-                                std::lock_guard<std::mutex> lk(fMtx);
-                                fOp.Timeout(fStateData);
-                            }
-                        });
+                    fTimer = fTimers.Schedule(timeout, std::move(onTimeout));
                 }
-                if (fTasks.empty())
+                if (fTasks.none())
                 {
                     OLOG(ESeverity::warning)
                         << "ChangeState initiated on an empty set of tasks, check the path argument.";
                 }
             }
+
+          public:
             ChangeStateOp() = delete;
             ChangeStateOp(const ChangeStateOp&) = delete;
             ChangeStateOp& operator=(const ChangeStateOp&) = delete;
@@ -750,78 +1645,268 @@ namespace odc::core
             ~ChangeStateOp() = default;
 
             /// precondition: fMtx is locked.
-            auto ResetCount(const FairMQTopologyStateIndex& stateIndex, const FairMQTopologyState& stateData) -> void
-            {
-                fCount = std::count_if(stateIndex.cbegin(),
-                                       stateIndex.cend(),
-                                       [=](const auto& s)
-                                       {
-                                           if (ContainsTask(stateData.at(s.second).taskId))
-                                           {
-                                               return stateData.at(s.second).state == fTargetState;
-                                           }
-                                           else
-                                           {
-                                               return false;
-                                           }
-                                       });
+            auto ResetCount(const DeviceStateTable& stateTable) -> void
+            {
+                if (fSteps.empty())
+                {
+                    stateTable.Read(
+                        [&](const DeviceStateColumns& columns)
+                        { fReached = fTasks & DeviceStateColumns::EqualSet(columns.state, fTargetStates.front()); });
+                }
+                else
+                {
+                    // devices of a sequence have to go through all the steps
+                    fReached.reset();
+                }
             }
 
             /// precondition: fMtx is locked.
-            auto Update(const DDSTask::Id taskId, const DeviceState currentState) -> void
+            /// precondition: index is one of the tasks of this operation.
+            /// @return next transition of the sequence for this task, if it has just completed an intermediate step
+            auto Update(const std::size_t index, const DeviceState currentState) -> std::optional<TopologyTransition>
             {
-                if (!fOp.IsCompleted() && ContainsTask(taskId))
+                std::optional<TopologyTransition> next;
+                if (!IsCompleted())
                 {
-                    if (currentState == fTargetState)
+                    if (currentState == GetTargetState(index))
                     {
-                        ++fCount;
+                        if (fSteps.empty() || fSteps[index] + 1 == fTargetStates.size())
+                        {
+                            // a device may report its target state again, only its first arrival is sampled
+                            if (!fReached.test(index))
+                            {
+                                fReached.set(index);
+                                auto const latency = std::chrono::duration_cast<Duration>(
+                                    fStateTable.GetStateEntered(index) - fStart);
+                                fLatencies.emplace_back(index, std::max(latency, Duration(0)));
+                            }
+                        }
+                        else
+                        {
+                            next = fTransitions[++fSteps[index]];
+                        }
                     }
                     TryCompletion();
+                    NotifyProgress();
                 }
+                return next;
             }
 
             /// precondition: fMtx is locked.
             auto TryCompletion() -> void
             {
-                if (!fOp.IsCompleted() && fCount == fTasks.size())
+                if (IsCompleted())
+                {
+                    return;
+                }
+                if (IsQuorumReached())
                 {
                     Complete(std::error_code());
                 }
+                else if ((fReached | fFailed) == fTasks)
+                {
+                    // excluded devices are in Error state in the reported topology state
+                    Complete(fFailed.any() ? MakeErrorCode(ErrorCode::DevicesExcluded) : std::error_code());
+                }
+            }
+
+            /// precondition: fMtx is locked.
+            /// precondition: index is one of the tasks of this operation.
+            auto DeviceFailed(const std::size_t index, const DeviceFailurePolicy policy) -> void
+            {
+                if (IsCompleted() || fReached.test(index) || policy == DeviceFailurePolicy::Wait)
+                {
+                    return;
+                }
+                fFailed.set(index);
+                if (policy == DeviceFailurePolicy::FailFast && !IsQuorumReachable())
+                {
+                    Complete(MakeErrorCode(ErrorCode::DeviceChangeStateFailed));
+                    return;
+                }
+                TryCompletion();
+                NotifyProgress();
             }
 
             /// precondition: fMtx is locked.
             auto Complete(std::error_code ec) -> void
             {
-                fTimer.cancel();
-                fOp.Complete(ec, fStateData);
+                fTimers.Cancel(fTimer);
+                ReportLatencies();
+                if (fQuorum)
+                {
+                    fQuorumOp.Complete(ec, fStateTable.Copy(), GetLaggards());
+                }
+                else
+                {
+                    fOp.Complete(ec, fStateTable.Copy());
+                }
             }
 
             /// precondition: fMtx is locked.
-            auto ContainsTask(DDSTask::Id id) -> bool
+            auto Timeout() -> void
             {
-                auto it =
-                    std::find_if(fTasks.begin(), fTasks.end(), [id](const DDSTask& t) { return t.GetId() == id; });
-                return it != fTasks.end();
+                ReportLatencies();
+                if (fQuorum)
+                {
+                    fQuorumOp.Timeout(fStateTable.Copy(), GetLaggards());
+                }
+                else
+                {
+                    fOp.Timeout(fStateTable.Copy());
+                }
             }
 
             bool IsCompleted()
             {
-                return fOp.IsCompleted();
+                return fOp.IsCompleted() && fQuorumOp.IsCompleted();
+            }
+
+            auto GetTasks() const -> const TaskSet&
+            {
+                return fTasks;
             }
 
-            auto GetTargetState() const -> DeviceState
+            auto SetProgressReporter(std::unique_ptr<ProgressReporter> progress) -> void
             {
-                return fTargetState;
+                fProgress = std::move(progress);
+            }
+
+            /// precondition: fMtx is locked.
+            auto NotifyProgress() -> void
+            {
+                if (fProgress && !IsCompleted())
+                {
+                    fProgress->Notify(fReached.count());
+                }
+            }
+
+            /// precondition: fMtx is locked.
+            auto OnProgressTimer() -> void
+            {
+                if (fProgress && !IsCompleted())
+                {
+                    fProgress->OnTimer();
+                }
+            }
+
+            /// precondition: fMtx is locked.
+            /// precondition: index is one of the tasks of this operation.
+            auto Awaits(const std::size_t index, const DeviceState currentState) -> bool
+            {
+                return !IsCompleted() && !fReached.test(index) && currentState == GetTargetState(index);
+            }
+
+            auto SetLatencyHandler(const ProgressOptions& progress) -> void
+            {
+                fLatencyHandler = progress.latencyHandler;
+                fLatencyTopK = progress.latencyTopK;
+            }
+
+            /// @brief target state of the current step of the given task
+            auto GetTargetState(const std::size_t index) const -> DeviceState
+            {
+                return fTargetStates[fSteps.empty() ? 0 : fSteps[index]];
+            }
+
+            auto GetTargetStates() const -> const std::vector<DeviceState>&
+            {
+                return fTargetStates;
+            }
+
+            /// @brief Latencies of the tasks which entered the target state during this operation, followed by the
+            /// still pending ones with the time elapsed so far
+            /// precondition: fMtx is locked.
+            auto GetLatencies() const -> TransitionLatencies
+            {
+                TransitionLatencies result;
+                if (fTransitions.empty())
+                {
+                    result.transition = "-> " + fair::mq::GetStateName(fTargetStates.back());
+                }
+                for (auto const& transition : fTransitions)
+                {
+                    result.transition += (result.transition.empty() ? "" : ", ") +
+                                         fair::mq::GetTransitionName(transition);
+                }
+
+                result.devices.reserve(fLatencies.size());
+                for (auto const& [index, latency] : fLatencies)
+                {
+                    result.devices.push_back({ fStateTable.Get(index).taskId, latency, true });
+                }
+                auto const elapsed =
+                    std::chrono::duration_cast<Duration>(DeviceStateColumns::Clock::now() - fStart);
+                for (auto id : GetLaggards())
+                {
+                    result.devices.push_back({ id, elapsed, false });
+                }
+                return result;
             }
 
           private:
+            /// precondition: fMtx is locked.
+            auto ReportLatencies() -> void
+            {
+                if (fLatencyHandler && !IsCompleted())
+                {
+                    try
+                    {
+                        fLatencyHandler(MakeTransitionStats(GetLatencies(), fLatencyTopK));
+                    }
+                    catch (const std::exception& e)
+                    {
+                        OLOG(ESeverity::error) << "Exception in transition latency handler: " << e.what();
+                    }
+                }
+            }
+
+            /// precondition: fMtx is locked.
+            auto IsQuorumReached() const -> bool
+            {
+                return fQuorum &&
+                       (fReached.count() >= fMinReached || (fRequired.any() && fRequired.is_subset_of(fReached)));
+            }
+
+            /// precondition: fMtx is locked.
+            auto IsQuorumReachable() const -> bool
+            {
+                return fQuorum && (fTasks.count() - fFailed.count() >= fMinReached ||
+                                   (fRequired.any() && !fRequired.intersects(fFailed)));
+            }
+
+            /// precondition: fMtx is locked.
+            auto GetLaggards() const -> std::vector<DDSTask::Id>
+            {
+                std::vector<DDSTask::Id> laggards;
+                TaskSet const pending = fTasks - fReached;
+                for (auto i = pending.find_first(); i != TaskSet::npos; i = pending.find_next(i))
+                {
+                    laggards.push_back(fStateTable.Get(i).taskId);
+                }
+                return laggards;
+            }
+
             Id const fId;
             AsioAsyncOp<Executor, Allocator, ChangeStateCompletionSignature> fOp;
-            FairMQTopologyState& fStateData;
-            boost::asio::steady_timer fTimer;
-            Count fCount;
-            std::vector<DDSTask> fTasks;
-            DeviceState fTargetState;
+            AsioAsyncOp<Executor, Allocator, ChangeStateQuorumCompletionSignature> fQuorumOp; ///< only with quorum
+            const DeviceStateTable& fStateTable;
+            TimerWheel& fTimers;
+            TimerWheel::Id fTimer; ///< 0 without timeout
+            TaskSet fTasks;
+            TaskSet fReached; ///< tasks which have reached the final target state, subset of fTasks
+            std::vector<TopologyTransition> fTransitions; ///< empty if the devices walk to the target state themselves
+            std::vector<DeviceState> fTargetStates;       ///< expected state after each step
+            std::vector<std::size_t> fSteps;              ///< current step per task, empty for a single step
+            bool fQuorum;                                 ///< completes with fQuorumOp instead of fOp
+            std::size_t fMinReached;                      ///< number of tasks which is a quorum
+            TaskSet fRequired;                            ///< tasks of the required collections, a quorum if any
+            TaskSet fFailed;                              ///< failed tasks which are no longer waited for
+            std::unique_ptr<ProgressReporter> fProgress;  ///< null without progress reports
+            std::function<void(const TransitionLatencyStats&)> fLatencyHandler; ///< empty if not requested
+            std::size_t fLatencyTopK;
+            DeviceStateColumns::Clock::time_point fStart;
+            std::vector<std::pair<std::size_t, Duration>> fLatencies; ///< tasks in the order they reached the target
             std::mutex& fMtx;
         };
 
@@ -909,45 +1994,206 @@ namespace odc::core
                               Duration timeout,
                               CompletionToken&& token)
         {
+            return AsyncChangeStateSequence({ transition }, path, timeout, std::forward<CompletionToken>(token));
+        }
+
+        /// @brief Initiate a sequence of state transitions on selected FairMQ devices in this topology
+        ///
+        /// Every device is driven through the sequence on its own: as soon as a device has reached the expected state
+        /// of a transition, the next transition is sent to this device, without waiting for the other devices. The
+        /// operation completes once all devices have reached the expected state of the last transition, it fails as
+        /// soon as one transition fails on one device.
+        /// @param transitions FairMQ device state machine transitions, in order
+        /// @param path Select a subset of FairMQ devices in this topology, empty selects all
+        /// @param timeout Timeout in milliseconds for the whole sequence, 0 means no timeout
+        /// @param progress Optional progress reports, done counts the devices which completed the whole sequence
+        /// @param token Asio completion token
+        /// @tparam CompletionToken Asio completion token type
+        /// @throws std::system_error
+        /// @throws RuntimeError if the sequence is empty
+        template <typename CompletionToken>
+        auto AsyncChangeStateSequence(std::vector<TopologyTransition> transitions,
+                                      const std::string& path,
+                                      Duration timeout,
+                                      const ProgressOptions& progress,
+                                      CompletionToken&& token)
+        {
+            if (transitions.empty())
+            {
+                throw RuntimeError("Empty sequence of transitions");
+            }
+
             return boost::asio::async_initiate<CompletionToken, ChangeStateCompletionSignature>(
-                [&](auto handler)
+                [&, transitions = std::move(transitions)](auto handler)
                 {
-                    typename ChangeStateOp::Id const id(uuidHash());
+                    std::vector<DeviceState> targetStates;
+                    for (auto const transition : transitions)
+                    {
+                        targetStates.push_back(expectedState.at(transition));
+                    }
 
                     std::lock_guard<std::mutex> lk(*fMtx);
 
-                    for (auto it = begin(fChangeStateOps); it != end(fChangeStateOps);)
+                    auto const it =
+                        AddChangeStateOp(transitions, std::move(targetStates), path, timeout, std::move(handler));
+                    auto& op = it->second;
+                    op.SetLatencyHandler(progress);
+
+                    fDDSCustomCmd.send(cc::EncodedCmds::ChangeState(transitions.front()), path);
+
+                    op.ResetCount(fStateTable);
+                    HandleFailedDevices(op);
+                    if (transitions.size() > 1)
                     {
-                        if (it->second.IsCompleted())
-                        {
-                            it = fChangeStateOps.erase(it);
-                        }
-                        else
+                        // Devices which have already reported the first step before the op was registered will not
+                        // report it again, advance them here.
+                        auto const firstState = op.GetTargetStates().front();
+                        for (auto const& [index, taskId] : GetTasksInState(op.GetTasks(), firstState))
                         {
-                            ++it;
+                            if (auto const next = op.Update(index, firstState))
+                            {
+                                auto const& taskPath = fDDSTopo.getRuntimeTaskById(taskId).m_taskPath;
+                                fDDSCustomCmd.send(cc::EncodedCmds::ChangeState(*next),
+                                                   ExactTaskPathCondition(taskPath));
+                            }
                         }
                     }
-
-                    auto p =
-                        fChangeStateOps.emplace(std::piecewise_construct,
-                                                std::forward_as_tuple(id),
-                                                std::forward_as_tuple(id,
-                                                                      transition,
-                                                                      GetTasks(path),
-                                                                      fStateData,
-                                                                      timeout,
-                                                                      *fMtx,
-                                                                      AsioBase<Executor, Allocator>::GetExecutor(),
-                                                                      AsioBase<Executor, Allocator>::GetAllocator(),
-                                                                      std::move(handler)));
-
-                    cc::Cmds cmds(cc::make<cc::ChangeState>(transition));
-                    fDDSCustomCmd.send(cmds.Serialize(), path);
-
-                    p.first->second.ResetCount(fStateIndex, fStateData);
                     // TODO: make sure following operation properly queues the completion and not doing it directly out
                     // of initiation call.
-                    p.first->second.TryCompletion();
+                    op.TryCompletion();
+                    EnableProgress(fChangeStateOps, it, progress, op.GetTasks());
+                    RetireIfCompleted(fChangeStateOps, it);
+                },
+                token);
+        }
+
+        /// @brief Initiate a sequence of state transitions on selected FairMQ devices in this topology
+        /// @param transitions FairMQ device state machine transitions, in order
+        /// @param path Select a subset of FairMQ devices in this topology, empty selects all
+        /// @param timeout Timeout in milliseconds for the whole sequence, 0 means no timeout
+        /// @param token Asio completion token
+        /// @tparam CompletionToken Asio completion token type
+        /// @throws std::system_error
+        /// @throws RuntimeError if the sequence is empty
+        template <typename CompletionToken>
+        auto AsyncChangeStateSequence(std::vector<TopologyTransition> transitions,
+                                      const std::string& path,
+                                      Duration timeout,
+                                      CompletionToken&& token)
+        {
+            return AsyncChangeStateSequence(
+                std::move(transitions), path, timeout, ProgressOptions(), std::forward<CompletionToken>(token));
+        }
+
+        /// @brief Initiate a walk of selected FairMQ devices in this topology to a target state
+        ///
+        /// Only the target state is sent, every device walks its state machine to the target state on its own along
+        /// the shortest path and reports the result once. The operation completes once all devices have reached the
+        /// target state, it fails as soon as one device fails to reach it.
+        /// @param targetState FairMQ device state to reach, a stable state or Exiting
+        /// @param path Select a subset of FairMQ devices in this topology, empty selects all
+        /// @param timeout Timeout in milliseconds for the whole walk, 0 means no timeout
+        /// @param progress Optional progress reports, rate-limited and coalesced
+        /// @param token Asio completion token
+        /// @tparam CompletionToken Asio completion token type
+        /// @throws std::system_error
+        template <typename CompletionToken>
+        auto AsyncChangeStateTo(const DeviceState targetState,
+                                const std::string& path,
+                                Duration timeout,
+                                const ProgressOptions& progress,
+                                CompletionToken&& token)
+        {
+            return boost::asio::async_initiate<CompletionToken, ChangeStateCompletionSignature>(
+                [&](auto handler)
+                {
+                    std::lock_guard<std::mutex> lk(*fMtx);
+
+                    auto const it = AddChangeStateOp({}, { targetState }, path, timeout, std::move(handler));
+                    auto& op = it->second;
+                    op.SetLatencyHandler(progress);
+
+                    fDDSCustomCmd.send(cc::EncodedCmds::ChangeStateTo(targetState), path);
+
+                    op.ResetCount(fStateTable);
+                    HandleFailedDevices(op);
+                    op.TryCompletion();
+                    EnableProgress(fChangeStateOps, it, progress, op.GetTasks());
+                    RetireIfCompleted(fChangeStateOps, it);
+                },
+                token);
+        }
+
+        /// @brief Initiate a walk of selected FairMQ devices in this topology to a target state
+        /// @param targetState FairMQ device state to reach, a stable state or Exiting
+        /// @param path Select a subset of FairMQ devices in this topology, empty selects all
+        /// @param timeout Timeout in milliseconds for the whole walk, 0 means no timeout
+        /// @param token Asio completion token
+        /// @tparam CompletionToken Asio completion token type
+        /// @throws std::system_error
+        template <typename CompletionToken>
+        auto AsyncChangeStateTo(const DeviceState targetState,
+                                const std::string& path,
+                                Duration timeout,
+                                CompletionToken&& token)
+        {
+            return AsyncChangeStateTo(
+                targetState, path, timeout, ProgressOptions(), std::forward<CompletionToken>(token));
+        }
+
+        /// @brief Initiate state transition on selected FairMQ devices in this topology with progress reports
+        /// @param transition FairMQ device state machine transition
+        /// @param path Select a subset of FairMQ devices in this topology, empty selects all
+        /// @param timeout Timeout in milliseconds, 0 means no timeout
+        /// @param progress Progress reports, rate-limited and coalesced
+        /// @param token Asio completion token
+        /// @tparam CompletionToken Asio completion token type
+        /// @throws std::system_error
+        template <typename CompletionToken>
+        auto AsyncChangeState(const TopologyTransition transition,
+                              const std::string& path,
+                              Duration timeout,
+                              const ProgressOptions& progress,
+                              CompletionToken&& token)
+        {
+            return AsyncChangeStateSequence(
+                { transition }, path, timeout, progress, std::forward<CompletionToken>(token));
+        }
+
+        /// @brief Initiate state transition on selected FairMQ devices in this topology, completing on a quorum
+        ///
+        /// Instead of waiting for the last device, the operation completes successfully as soon as the quorum has
+        /// reached the expected state. The handler receives the tasks which have not (yet), which are not waited for
+        /// any longer. On failure or timeout, the laggards are passed as well.
+        /// @param transition FairMQ device state machine transition
+        /// @param path Select a subset of FairMQ devices in this topology, empty selects all
+        /// @param timeout Timeout in milliseconds, 0 means no timeout
+        /// @param quorum Completion policy
+        /// @param token Asio completion token with signature ChangeStateQuorumCompletionSignature
+        /// @tparam CompletionToken Asio completion token type
+        /// @throws std::system_error
+        template <typename CompletionToken>
+        auto AsyncChangeState(const TopologyTransition transition,
+                              const std::string& path,
+                              Duration timeout,
+                              const ChangeStateQuorum& quorum,
+                              CompletionToken&& token)
+        {
+            return boost::asio::async_initiate<CompletionToken, ChangeStateQuorumCompletionSignature>(
+                [&](auto handler)
+                {
+                    std::lock_guard<std::mutex> lk(*fMtx);
+
+                    auto const it = AddChangeStateOp(
+                        { transition }, { expectedState.at(transition) }, path, timeout, quorum, std::move(handler));
+                    auto& op = it->second;
+
+                    fDDSCustomCmd.send(cc::EncodedCmds::ChangeState(transition), path);
+
+                    op.ResetCount(fStateTable);
+                    HandleFailedDevices(op);
+                    op.TryCompletion();
+                    RetireIfCompleted(fChangeStateOps, it);
                 },
                 token);
         }
@@ -1022,22 +2268,222 @@ namespace odc::core
             return ChangeState(transition, "", timeout);
         }
 
+        /// @brief Perform a sequence of state transitions on FairMQ devices in this topology, see
+        /// AsyncChangeStateSequence
+        /// @param transitions FairMQ device state machine transitions, in order
+        /// @param path Select a subset of FairMQ devices in this topology, empty selects all
+        /// @param timeout Timeout in milliseconds for the whole sequence, 0 means no timeout
+        /// @throws std::system_error
+        auto ChangeStateSequence(std::vector<TopologyTransition> transitions,
+                                 const std::string& path = "",
+                                 Duration timeout = Duration(0)) -> std::pair<std::error_code, FairMQTopologyState>
+        {
+            SharedSemaphore blocker;
+            std::error_code ec;
+            FairMQTopologyState state;
+            AsyncChangeStateSequence(std::move(transitions),
+                                     path,
+                                     timeout,
+                                     [&, blocker](std::error_code _ec, FairMQTopologyState _state) mutable
+                                     {
+                                         ec = _ec;
+                                         state = _state;
+                                         blocker.Signal();
+                                     });
+            blocker.Wait();
+            return { ec, state };
+        }
+
+        /// @brief Walk FairMQ devices in this topology to a target state, see AsyncChangeStateTo
+        /// @param targetState FairMQ device state to reach, a stable state or Exiting
+        /// @param path Select a subset of FairMQ devices in this topology, empty selects all
+        /// @param timeout Timeout in milliseconds for the whole walk, 0 means no timeout
+        /// @throws std::system_error
+        auto ChangeStateTo(const DeviceState targetState, const std::string& path = "", Duration timeout = Duration(0))
+            -> std::pair<std::error_code, FairMQTopologyState>
+        {
+            SharedSemaphore blocker;
+            std::error_code ec;
+            FairMQTopologyState state;
+            AsyncChangeStateTo(targetState,
+                               path,
+                               timeout,
+                               [&, blocker](std::error_code _ec, FairMQTopologyState _state) mutable
+                               {
+                                   ec = _ec;
+                                   state = _state;
+                                   blocker.Signal();
+                               });
+            blocker.Wait();
+            return { ec, state };
+        }
+
+        /// @brief Subscribe to the state changes of selected FairMQ devices in this topology
+        ///
+        /// The handler is invoked on the executor of the topology with the changes since its previous invocation,
+        /// never concurrently with itself. The changes of a device are coalesced into a single entry while the
+        /// observer is busy, so a slow observer skips intermediate states instead of holding up the topology.
+        /// @param path Select a subset of FairMQ devices in this topology, empty selects all
+        /// @param handler Invoked with a batch of changes, at most one per device
+        /// @return id of the subscription
+        auto SubscribeStateChanges(const std::string& path, StateChangeHandler handler) -> StateObserverId
+        {
+            StateObserverId const id(uuidHash());
+            auto observer = std::make_shared<StateObserver>(
+                GetTaskSet(path), std::move(handler), AsioBase<Executor, Allocator>::GetExecutor());
+            std::lock_guard<std::mutex> lk(*fMtx);
+            fStateObservers.emplace(id, std::move(observer));
+            return id;
+        }
+
+        /// @brief Cancel a state change subscription, no delivery starts after this returns
+        /// @return false if there is no such subscription
+        auto UnsubscribeStateChanges(const StateObserverId id) -> bool
+        {
+            std::lock_guard<std::mutex> lk(*fMtx);
+            auto it = fStateObservers.find(id);
+            if (it == fStateObservers.end())
+            {
+                return false;
+            }
+            it->second->Deactivate();
+            fStateObservers.erase(it);
+            return true;
+        }
+
+        /// @brief Set the time the incoming commands are collected for before they are processed as one batch
+        ///
+        /// Repeated state changes of a device within a batch are coalesced into the latest one, so a longer window
+        /// means less work per state change during large transitions, at the cost of latency. Task done events are
+        /// not held back by the window, a crash is thus applied before state changes the task has sent earlier but
+        /// which are still collected. Those are ignored, the state of an exited task is final.
+        /// @param window 0 (default) processes whatever has arrived right away
+        auto SetCoalescingWindow(const Duration window) -> void
+        {
+            fIngress->SetCoalescingWindow(window);
+        }
+
+        /// @brief Set how pending and new operations react to a device crashing or entering Error state
+        /// @param policy FailFast by default
+        auto SetDeviceFailurePolicy(const DeviceFailurePolicy policy) -> void
+        {
+            std::lock_guard<std::mutex> lk(*fMtx);
+            fDeviceFailurePolicy = policy;
+        }
+
+        auto GetDeviceFailurePolicy() const -> DeviceFailurePolicy
+        {
+            std::lock_guard<std::mutex> lk(*fMtx);
+            return fDeviceFailurePolicy;
+        }
+
+        /// @brief Latency distribution of the last completed change state operation, to spot the devices slowing it
+        /// down
+        ///
+        /// The latency of a device is the time from the initiation of the operation until the device entered the
+        /// target state. Devices already in the target state at initiation are not counted. With concurrent
+        /// operations this is whichever completed last, use ProgressOptions::latencyHandler for the latencies of a
+        /// particular operation.
+        /// @param topK maximum number of devices in TransitionLatencyStats::slowest
+        auto GetLastTransitionStats(const std::size_t topK = 10) const -> TransitionLatencyStats
+        {
+            TransitionLatencies latencies;
+            {
+                std::lock_guard<std::mutex> lk(*fMtx);
+                latencies = fLastTransitionLatencies;
+            }
+
+            return MakeTransitionStats(std::move(latencies), topK);
+        }
+
         /// @brief Returns the current state of the topology
         /// @return map of id : DeviceStatus
         auto GetCurrentState() const -> FairMQTopologyState
         {
-            std::lock_guard<std::mutex> lk(*fMtx);
-            return fStateData;
+            return fStateTable.Copy();
+        }
+
+        /// @brief Returns a shared immutable snapshot of the current state of the topology
+        /// @return snapshot, shared with other readers as long as no device state changed in between
+        auto GetStateSnapshot() const -> FairMQTopologyStateSnapshotPtr
+        {
+            return fStateTable.Snapshot();
         }
 
-        auto AggregateState() const -> DeviceState
+        /// @brief Aggregated state of the whole topology, O(1) in the number of devices
+        auto AggregateState() const -> AggregatedTopologyState
         {
-            return AggregateState(GetCurrentState());
+            return fStateTable.AggregateState();
+        }
+
+        /// @brief Aggregated state of the devices selected by path
+        /// @param path If it equals the path of a single task, the state of that task is returned, otherwise the
+        ///             aggregation over all tasks matching the path. Empty selects all.
+        /// @throws RuntimeError if no task matches the path
+        auto AggregateState(const std::string& path) const -> AggregatedTopologyState
+        {
+            if (path.empty())
+            {
+                return AggregateState();
+            }
+
+            auto const selection = GetTaskSelection(path);
+            if (selection->exactIndex != TaskSet::npos)
+            {
+                return static_cast<AggregatedTopologyState>(fStateTable.Get(selection->exactIndex).state);
+            }
+
+            TaskSet const& tasks = selection->indices;
+            auto const first = tasks.find_first();
+            if (first == TaskSet::npos)
+            {
+                throw RuntimeError("No tasks found matching the path ", path);
+            }
+            return fStateTable.Read(
+                [&](const DeviceStateColumns& columns)
+                {
+                    std::uint8_t const firstState = columns.state[first];
+                    for (auto i = tasks.find_next(first); i != TaskSet::npos; i = tasks.find_next(i))
+                    {
+                        if (columns.state[i] != firstState)
+                        {
+                            return AggregatedTopologyState::Mixed;
+                        }
+                    }
+                    return static_cast<AggregatedTopologyState>(columns.GetState(first));
+                });
         }
 
         auto StateEqualsTo(DeviceState state) const -> bool
         {
-            return StateEqualsTo(GetCurrentState(), state);
+            return fStateTable.GetStateCount(state) == fStateTable.Size();
+        }
+
+        /// @brief Status of the devices whose current state differs from the given state
+        auto GetDevicesNotInState(DeviceState state) const -> FairMQTopologyState
+        {
+            return fStateTable.Read(
+                [&](const DeviceStateColumns& columns)
+                {
+                    FairMQTopologyState result;
+                    for (auto const i :
+                         FindStateMismatches(columns.state.data(), columns.Size(), static_cast<std::uint8_t>(state)))
+                    {
+                        result.push_back(columns.Get(i));
+                    }
+                    return result;
+                });
+        }
+
+        auto GetNumDevices() const -> std::size_t
+        {
+            return fStateTable.Size();
+        }
+
+        /// @brief Number of devices of the topology currently in the given state, O(1)
+        auto GetStateCount(DeviceState state) const -> std::size_t
+        {
+            return fStateTable.GetStateCount(state);
         }
 
         using WaitForStateCompletionSignature = void(std::error_code);
@@ -1046,41 +2492,35 @@ namespace odc::core
         struct WaitForStateOp
         {
             using Id = std::size_t;
-            using Count = unsigned int;
 
             template <typename Handler>
             WaitForStateOp(Id id,
                            DeviceState targetLastState,
                            DeviceState targetCurrentState,
-                           std::vector<DDSTask> tasks,
+                           TaskSet tasks,
                            Duration timeout,
+                           TimerWheel& timers,
+                           TimerWheel::Callback onTimeout,
                            std::mutex& mutex,
                            Executor const& ex,
                            Allocator const& alloc,
                            Handler&& handler)
                 : fId(id)
                 , fOp(ex, alloc, std::move(handler))
-                , fTimer(ex)
-                , fCount(0)
+                , fTimers(timers)
+                , fTimer(0)
                 , fTasks(std::move(tasks))
+                , fReached(fTasks.size())
+                , fFailed(fTasks.size())
                 , fTargetLastState(targetLastState)
                 , fTargetCurrentState(targetCurrentState)
                 , fMtx(mutex)
             {
                 if (timeout > std::chrono::milliseconds(0))
                 {
-                    fTimer.expires_after(timeout);
-                    fTimer.async_wait(
-                        [&](std::error_code ec)
-                        {
-                            if (!ec)
-                            {
-                                std::lock_guard<std::mutex> lk(fMtx);
-                                fOp.Timeout();
-                            }
-                        });
+                    fTimer = fTimers.Schedule(timeout, std::move(onTimeout));
                 }
-                if (fTasks.empty())
+                if (fTasks.none())
                 {
                     OLOG(ESeverity::warning)
                         << "WaitForState initiated on an empty set of tasks, check the path argument.";
@@ -1093,71 +2533,135 @@ namespace odc::core
             WaitForStateOp& operator=(WaitForStateOp&&) = default;
             ~WaitForStateOp() = default;
 
-            /// precondition: fMtx is locked.
-            auto ResetCount(const FairMQTopologyStateIndex& stateIndex, const FairMQTopologyState& stateData) -> void
-            {
-                fCount = std::count_if(stateIndex.cbegin(),
-                                       stateIndex.cend(),
-                                       [=](const auto& s)
-                                       {
-                                           if (ContainsTask(stateData.at(s.second).taskId))
-                                           {
-                                               return stateData.at(s.second).state == fTargetCurrentState &&
-                                                      (stateData.at(s.second).lastState == fTargetLastState ||
-                                                       fTargetLastState == DeviceState::Undefined);
-                                           }
-                                           else
-                                           {
-                                               return false;
-                                           }
-                                       });
+            /// precondition: fMtx is locked.
+            auto ResetCount(const DeviceStateTable& stateTable) -> void
+            {
+                stateTable.Read(
+                    [&](const DeviceStateColumns& columns)
+                    {
+                        fReached = fTasks & DeviceStateColumns::EqualSet(columns.state, fTargetCurrentState);
+                        if (fTargetLastState != DeviceState::Undefined)
+                        {
+                            fReached &= DeviceStateColumns::EqualSet(columns.lastState, fTargetLastState);
+                        }
+                    });
+            }
+
+            /// precondition: fMtx is locked.
+            /// precondition: index is one of the tasks of this operation.
+            auto Update(const std::size_t index, const DeviceState lastState, const DeviceState currentState) -> void
+            {
+                if (!fOp.IsCompleted())
+                {
+                    if (Matches(lastState, currentState))
+                    {
+                        fReached.set(index);
+                    }
+                    TryCompletion();
+                    NotifyProgress();
+                }
+            }
+
+            /// precondition: fMtx is locked.
+            /// precondition: index is one of the tasks of this operation.
+            auto Awaits(const std::size_t index, const DeviceState lastState, const DeviceState currentState) const
+                -> bool
+            {
+                return !fOp.IsCompleted() && !fReached.test(index) && Matches(lastState, currentState);
+            }
+
+            /// precondition: fMtx is locked.
+            auto TryCompletion() -> void
+            {
+                if (!fOp.IsCompleted() && (fReached | fFailed) == fTasks)
+                {
+                    fTimers.Cancel(fTimer);
+                    if (fFailed.any())
+                    {
+                        fOp.Complete(MakeErrorCode(ErrorCode::DevicesExcluded));
+                    }
+                    else
+                    {
+                        fOp.Complete();
+                    }
+                }
+            }
+
+            /// precondition: fMtx is locked.
+            /// precondition: index is one of the tasks of this operation.
+            auto DeviceFailed(const std::size_t index, const DeviceFailurePolicy policy) -> void
+            {
+                if (fOp.IsCompleted() || fReached.test(index) || policy == DeviceFailurePolicy::Wait)
+                {
+                    return;
+                }
+                if (policy == DeviceFailurePolicy::FailFast)
+                {
+                    fTimers.Cancel(fTimer);
+                    fOp.Complete(MakeErrorCode(ErrorCode::DeviceFailed));
+                    return;
+                }
+                fFailed.set(index);
+                TryCompletion();
+                NotifyProgress();
+            }
+
+            /// precondition: fMtx is locked.
+            auto Timeout() -> void
+            {
+                fOp.Timeout();
+            }
+
+            bool IsCompleted()
+            {
+                return fOp.IsCompleted();
+            }
+
+            auto GetTasks() const -> const TaskSet&
+            {
+                return fTasks;
             }
 
-            /// precondition: fMtx is locked.
-            auto Update(const DDSTask::Id taskId, const DeviceState lastState, const DeviceState currentState) -> void
+            auto SetProgressReporter(std::unique_ptr<ProgressReporter> progress) -> void
             {
-                if (!fOp.IsCompleted() && ContainsTask(taskId))
-                {
-                    if (currentState == fTargetCurrentState &&
-                        (lastState == fTargetLastState || fTargetLastState == DeviceState::Undefined))
-                    {
-                        ++fCount;
-                    }
-                    TryCompletion();
-                }
+                fProgress = std::move(progress);
             }
 
             /// precondition: fMtx is locked.
-            auto TryCompletion() -> void
+            auto NotifyProgress() -> void
             {
-                if (!fOp.IsCompleted() && fCount == fTasks.size())
+                if (fProgress && !IsCompleted())
                 {
-                    fTimer.cancel();
-                    fOp.Complete();
+                    fProgress->Notify(fReached.count());
                 }
             }
 
-            bool IsCompleted()
+            /// precondition: fMtx is locked.
+            auto OnProgressTimer() -> void
             {
-                return fOp.IsCompleted();
+                if (fProgress && !IsCompleted())
+                {
+                    fProgress->OnTimer();
+                }
             }
 
           private:
             Id const fId;
             AsioAsyncOp<Executor, Allocator, WaitForStateCompletionSignature> fOp;
-            boost::asio::steady_timer fTimer;
-            Count fCount;
-            std::vector<DDSTask> fTasks;
+            TimerWheel& fTimers;
+            TimerWheel::Id fTimer; ///< 0 without timeout
+            TaskSet fTasks;
+            TaskSet fReached; ///< tasks which have reached the target states, subset of fTasks
+            TaskSet fFailed;  ///< failed tasks which are no longer waited for
             DeviceState fTargetLastState;
             DeviceState fTargetCurrentState;
+            std::unique_ptr<ProgressReporter> fProgress; ///< null without progress reports
             std::mutex& fMtx;
 
-            /// precondition: fMtx is locked.
-            auto ContainsTask(DDSTask::Id id) -> bool
+            auto Matches(const DeviceState lastState, const DeviceState currentState) const -> bool
             {
-                auto it =
-                    std::find_if(fTasks.begin(), fTasks.end(), [id](const DDSTask& t) { return t.GetId() == id; });
-                return it != fTasks.end();
+                return currentState == fTargetCurrentState &&
+                       (lastState == fTargetLastState || fTargetLastState == DeviceState::Undefined);
             }
         };
 
@@ -1167,6 +2671,7 @@ namespace odc::core
         /// @param targetCurrentState the target device state to wait for
         /// @param path Select a subset of FairMQ devices in this topology, empty selects all
         /// @param timeout Timeout in milliseconds, 0 means no timeout
+        /// @param progress Optional progress reports, rate-limited and coalesced
         /// @param token Asio completion token
         /// @tparam CompletionToken Asio completion token type
         /// @throws std::system_error
@@ -1175,6 +2680,7 @@ namespace odc::core
                                const DeviceState targetCurrentState,
                                const std::string& path,
                                Duration timeout,
+                               const ProgressOptions& progress,
                                CompletionToken&& token)
         {
             return boost::asio::async_initiate<CompletionToken, WaitForStateCompletionSignature>(
@@ -1184,38 +2690,55 @@ namespace odc::core
 
                     std::lock_guard<std::mutex> lk(*fMtx);
 
-                    for (auto it = begin(fWaitForStateOps); it != end(fWaitForStateOps);)
-                    {
-                        if (it->second.IsCompleted())
-                        {
-                            it = fWaitForStateOps.erase(it);
-                        }
-                        else
-                        {
-                            ++it;
-                        }
-                    }
-
                     auto p =
                         fWaitForStateOps.emplace(std::piecewise_construct,
                                                  std::forward_as_tuple(id),
                                                  std::forward_as_tuple(id,
                                                                        targetLastState,
                                                                        targetCurrentState,
-                                                                       GetTasks(path),
+                                                                       GetTaskSet(path),
                                                                        timeout,
+                                                                       *fTimers,
+                                                                       MakeTimeoutHandler(fWaitForStateOps, id),
                                                                        *fMtx,
                                                                        AsioBase<Executor, Allocator>::GetExecutor(),
                                                                        AsioBase<Executor, Allocator>::GetAllocator(),
                                                                        std::move(handler)));
-                    p.first->second.ResetCount(fStateIndex, fStateData);
+                    AddToTaskIndex(fWaitForStateOpsByTask, id, p.first->second.GetTasks());
+                    p.first->second.ResetCount(fStateTable);
+                    HandleFailedDevices(p.first->second);
                     // TODO: make sure following operation properly queues the completion and not doing it directly out
                     // of initiation call.
                     p.first->second.TryCompletion();
+                    EnableProgress(fWaitForStateOps, p.first, progress, p.first->second.GetTasks());
+                    RetireIfCompleted(fWaitForStateOps, p.first);
                 },
                 token);
         }
 
+        /// @brief Initiate waiting for selected FairMQ devices to reach given last & current state in this topology
+        /// @param targetLastState the target last device state to wait for
+        /// @param targetCurrentState the target device state to wait for
+        /// @param path Select a subset of FairMQ devices in this topology, empty selects all
+        /// @param timeout Timeout in milliseconds, 0 means no timeout
+        /// @param token Asio completion token
+        /// @tparam CompletionToken Asio completion token type
+        /// @throws std::system_error
+        template <typename CompletionToken>
+        auto AsyncWaitForState(const DeviceState targetLastState,
+                               const DeviceState targetCurrentState,
+                               const std::string& path,
+                               Duration timeout,
+                               CompletionToken&& token)
+        {
+            return AsyncWaitForState(targetLastState,
+                                     targetCurrentState,
+                                     path,
+                                     timeout,
+                                     ProgressOptions(),
+                                     std::forward<CompletionToken>(token));
+        }
+
         /// @brief Initiate waiting for selected FairMQ devices to reach given last & current state in this topology
         /// @param targetLastState the target last device state to wait for
         /// @param targetCurrentState the target device state to wait for
@@ -1291,29 +2814,23 @@ namespace odc::core
             GetPropertiesOp(Id id,
                             GetCount expectedCount,
                             Duration timeout,
+                            TimerWheel& timers,
+                            TimerWheel::Callback onTimeout,
                             std::mutex& mutex,
                             Executor const& ex,
                             Allocator const& alloc,
                             Handler&& handler)
                 : fId(id)
                 , fOp(ex, alloc, std::move(handler))
-                , fTimer(ex)
+                , fTimers(timers)
+                , fTimer(0)
                 , fCount(0)
                 , fExpectedCount(expectedCount)
                 , fMtx(mutex)
             {
                 if (timeout > std::chrono::milliseconds(0))
                 {
-                    fTimer.expires_after(timeout);
-                    fTimer.async_wait(
-                        [&](std::error_code ec)
-                        {
-                            if (!ec)
-                            {
-                                std::lock_guard<std::mutex> lk(fMtx);
-                                fOp.Timeout(fResult);
-                            }
-                        });
+                    fTimer = fTimers.Schedule(timeout, std::move(onTimeout));
                 }
                 if (expectedCount == 0)
                 {
@@ -1330,9 +2847,9 @@ namespace odc::core
             GetPropertiesOp& operator=(GetPropertiesOp&&) = default;
             ~GetPropertiesOp() = default;
 
+            /// precondition: fMtx is locked.
             auto Update(const std::string& deviceId, cc::Result result, DeviceProperties props) -> void
             {
-                std::lock_guard<std::mutex> lk(fMtx);
                 if (cc::Result::Ok != result)
                 {
                     fResult.failed.insert(deviceId);
@@ -1343,6 +2860,13 @@ namespace odc::core
                 }
                 ++fCount;
                 TryCompletion();
+                NotifyProgress();
+            }
+
+            /// precondition: fMtx is locked.
+            auto Timeout() -> void
+            {
+                fOp.Timeout(fResult);
             }
 
             bool IsCompleted()
@@ -1350,13 +2874,38 @@ namespace odc::core
                 return fOp.IsCompleted();
             }
 
+            auto SetProgressReporter(std::unique_ptr<ProgressReporter> progress) -> void
+            {
+                fProgress = std::move(progress);
+            }
+
+            /// precondition: fMtx is locked.
+            auto NotifyProgress() -> void
+            {
+                if (fProgress && !IsCompleted())
+                {
+                    fProgress->Notify(fCount);
+                }
+            }
+
+            /// precondition: fMtx is locked.
+            auto OnProgressTimer() -> void
+            {
+                if (fProgress && !IsCompleted())
+                {
+                    fProgress->OnTimer();
+                }
+            }
+
           private:
             Id const fId;
             AsioAsyncOp<Executor, Allocator, GetPropertiesCompletionSignature> fOp;
-            boost::asio::steady_timer fTimer;
+            TimerWheel& fTimers;
+            TimerWheel::Id fTimer; ///< 0 without timeout
             GetCount fCount;
             GetCount const fExpectedCount;
             GetPropertiesResult fResult;
+            std::unique_ptr<ProgressReporter> fProgress; ///< null without progress reports
             std::mutex& fMtx;
 
             /// precondition: fMtx is locked.
@@ -1364,7 +2913,7 @@ namespace odc::core
             {
                 if (!fOp.IsCompleted() && fCount == fExpectedCount)
                 {
-                    fTimer.cancel();
+                    fTimers.Cancel(fTimer);
                     if (!fResult.failed.empty())
                     {
                         fOp.Complete(MakeErrorCode(ErrorCode::DeviceGetPropertiesFailed), std::move(fResult));
@@ -1382,6 +2931,7 @@ namespace odc::core
         /// @param query Key(s) to be queried (regex)
         /// @param path Select a subset of FairMQ devices in this topology, empty selects all
         /// @param timeout Timeout in milliseconds, 0 means no timeout
+        /// @param progress Optional progress reports, done counts the replies
         /// @param token Asio completion token
         /// @tparam CompletionToken Asio completion token type
         /// @throws std::system_error
@@ -1389,6 +2939,7 @@ namespace odc::core
         auto AsyncGetProperties(DevicePropertyQuery const& query,
                                 const std::string& path,
                                 Duration timeout,
+                                const ProgressOptions& progress,
                                 CompletionToken&& token)
         {
             return boost::asio::async_initiate<CompletionToken, GetPropertiesCompletionSignature>(
@@ -1398,34 +2949,42 @@ namespace odc::core
 
                     std::lock_guard<std::mutex> lk(*fMtx);
 
-                    for (auto it = begin(fGetPropertiesOps); it != end(fGetPropertiesOps);)
-                    {
-                        if (it->second.IsCompleted())
-                        {
-                            it = fGetPropertiesOps.erase(it);
-                        }
-                        else
-                        {
-                            ++it;
-                        }
-                    }
-
-                    fGetPropertiesOps.emplace(std::piecewise_construct,
-                                              std::forward_as_tuple(id),
-                                              std::forward_as_tuple(id,
-                                                                    GetTasks(path).size(),
-                                                                    timeout,
-                                                                    *fMtx,
-                                                                    AsioBase<Executor, Allocator>::GetExecutor(),
-                                                                    AsioBase<Executor, Allocator>::GetAllocator(),
-                                                                    std::move(handler)));
+                    auto p =
+                        fGetPropertiesOps.emplace(std::piecewise_construct,
+                                                  std::forward_as_tuple(id),
+                                                  std::forward_as_tuple(id,
+                                                                        GetTasks(path).size(),
+                                                                        timeout,
+                                                                        *fTimers,
+                                                                        MakeTimeoutHandler(fGetPropertiesOps, id),
+                                                                        *fMtx,
+                                                                        AsioBase<Executor, Allocator>::GetExecutor(),
+                                                                        AsioBase<Executor, Allocator>::GetAllocator(),
+                                                                        std::move(handler)));
 
                     cc::Cmds const cmds(cc::make<cc::GetProperties>(id, query));
                     fDDSCustomCmd.send(cmds.Serialize(), path);
+                    EnableProgress(fGetPropertiesOps, p.first, progress, GetTaskSet(path));
                 },
                 token);
         }
 
+        /// @brief Initiate property query on selected FairMQ devices in this topology
+        /// @param query Key(s) to be queried (regex)
+        /// @param path Select a subset of FairMQ devices in this topology, empty selects all
+        /// @param timeout Timeout in milliseconds, 0 means no timeout
+        /// @param token Asio completion token
+        /// @tparam CompletionToken Asio completion token type
+        /// @throws std::system_error
+        template <typename CompletionToken>
+        auto AsyncGetProperties(DevicePropertyQuery const& query,
+                                const std::string& path,
+                                Duration timeout,
+                                CompletionToken&& token)
+        {
+            return AsyncGetProperties(query, path, timeout, ProgressOptions(), std::forward<CompletionToken>(token));
+        }
+
         /// @brief Initiate property query on selected FairMQ devices in this topology
         /// @param query Key(s) to be queried (regex)
         /// @param token Asio completion token
@@ -1474,29 +3033,23 @@ namespace odc::core
             SetPropertiesOp(Id id,
                             SetCount expectedCount,
                             Duration timeout,
+                            TimerWheel& timers,
+                            TimerWheel::Callback onTimeout,
                             std::mutex& mutex,
                             Executor const& ex,
                             Allocator const& alloc,
                             Handler&& handler)
                 : fId(id)
                 , fOp(ex, alloc, std::move(handler))
-                , fTimer(ex)
+                , fTimers(timers)
+                , fTimer(0)
                 , fCount(0)
                 , fExpectedCount(expectedCount)
                 , fMtx(mutex)
             {
                 if (timeout > std::chrono::milliseconds(0))
                 {
-                    fTimer.expires_after(timeout);
-                    fTimer.async_wait(
-                        [&](std::error_code ec)
-                        {
-                            if (!ec)
-                            {
-                                std::lock_guard<std::mutex> lk(fMtx);
-                                fOp.Timeout(fFailedDevices);
-                            }
-                        });
+                    fTimer = fTimers.Schedule(timeout, std::move(onTimeout));
                 }
                 if (expectedCount == 0)
                 {
@@ -1513,15 +3066,22 @@ namespace odc::core
             SetPropertiesOp& operator=(SetPropertiesOp&&) = default;
             ~SetPropertiesOp() = default;
 
+            /// precondition: fMtx is locked.
             auto Update(const std::string& deviceId, cc::Result result) -> void
             {
-                std::lock_guard<std::mutex> lk(fMtx);
                 if (cc::Result::Ok != result)
                 {
                     fFailedDevices.insert(deviceId);
                 }
                 ++fCount;
                 TryCompletion();
+                NotifyProgress();
+            }
+
+            /// precondition: fMtx is locked.
+            auto Timeout() -> void
+            {
+                fOp.Timeout(fFailedDevices);
             }
 
             bool IsCompleted()
@@ -1529,13 +3089,38 @@ namespace odc::core
                 return fOp.IsCompleted();
             }
 
+            auto SetProgressReporter(std::unique_ptr<ProgressReporter> progress) -> void
+            {
+                fProgress = std::move(progress);
+            }
+
+            /// precondition: fMtx is locked.
+            auto NotifyProgress() -> void
+            {
+                if (fProgress && !IsCompleted())
+                {
+                    fProgress->Notify(fCount);
+                }
+            }
+
+            /// precondition: fMtx is locked.
+            auto OnProgressTimer() -> void
+            {
+                if (fProgress && !IsCompleted())
+                {
+                    fProgress->OnTimer();
+                }
+            }
+
           private:
             Id const fId;
             AsioAsyncOp<Executor, Allocator, SetPropertiesCompletionSignature> fOp;
-            boost::asio::steady_timer fTimer;
+            TimerWheel& fTimers;
+            TimerWheel::Id fTimer; ///< 0 without timeout
             SetCount fCount;
             SetCount const fExpectedCount;
             FailedDevices fFailedDevices;
+            std::unique_ptr<ProgressReporter> fProgress; ///< null without progress reports
             std::mutex& fMtx;
 
             /// precondition: fMtx is locked.
@@ -1543,7 +3128,7 @@ namespace odc::core
             {
                 if (!fOp.IsCompleted() && fCount == fExpectedCount)
                 {
-                    fTimer.cancel();
+                    fTimers.Cancel(fTimer);
                     if (!fFailedDevices.empty())
                     {
                         fOp.Complete(MakeErrorCode(ErrorCode::DeviceSetPropertiesFailed), fFailedDevices);
@@ -1561,6 +3146,7 @@ namespace odc::core
         /// @param props Properties to set
         /// @param path Select a subset of FairMQ devices in this topology, empty selects all
         /// @param timeout Timeout in milliseconds, 0 means no timeout
+        /// @param progress Optional progress reports, done counts the replies
         /// @param token Asio completion token
         /// @tparam CompletionToken Asio completion token type
         /// @throws std::system_error
@@ -1568,6 +3154,7 @@ namespace odc::core
         auto AsyncSetProperties(const DeviceProperties& props,
                                 const std::string& path,
                                 Duration timeout,
+                                const ProgressOptions& progress,
                                 CompletionToken&& token)
         {
             return boost::asio::async_initiate<CompletionToken, SetPropertiesCompletionSignature>(
@@ -1577,34 +3164,42 @@ namespace odc::core
 
                     std::lock_guard<std::mutex> lk(*fMtx);
 
-                    for (auto it = begin(fGetPropertiesOps); it != end(fGetPropertiesOps);)
-                    {
-                        if (it->second.IsCompleted())
-                        {
-                            it = fGetPropertiesOps.erase(it);
-                        }
-                        else
-                        {
-                            ++it;
-                        }
-                    }
-
-                    fSetPropertiesOps.emplace(std::piecewise_construct,
-                                              std::forward_as_tuple(id),
-                                              std::forward_as_tuple(id,
-                                                                    GetTasks(path).size(),
-                                                                    timeout,
-                                                                    *fMtx,
-                                                                    AsioBase<Executor, Allocator>::GetExecutor(),
-                                                                    AsioBase<Executor, Allocator>::GetAllocator(),
-                                                                    std::move(handler)));
+                    auto p =
+                        fSetPropertiesOps.emplace(std::piecewise_construct,
+                                                  std::forward_as_tuple(id),
+                                                  std::forward_as_tuple(id,
+                                                                        GetTasks(path).size(),
+                                                                        timeout,
+                                                                        *fTimers,
+                                                                        MakeTimeoutHandler(fSetPropertiesOps, id),
+                                                                        *fMtx,
+                                                                        AsioBase<Executor, Allocator>::GetExecutor(),
+                                                                        AsioBase<Executor, Allocator>::GetAllocator(),
+                                                                        std::move(handler)));
 
                     cc::Cmds const cmds(cc::make<cc::SetProperties>(id, props));
                     fDDSCustomCmd.send(cmds.Serialize(), path);
+                    EnableProgress(fSetPropertiesOps, p.first, progress, GetTaskSet(path));
                 },
                 token);
         }
 
+        /// @brief Initiate property update on selected FairMQ devices in this topology
+        /// @param props Properties to set
+        /// @param path Select a subset of FairMQ devices in this topology, empty selects all
+        /// @param timeout Timeout in milliseconds, 0 means no timeout
+        /// @param token Asio completion token
+        /// @tparam CompletionToken Asio completion token type
+        /// @throws std::system_error
+        template <typename CompletionToken>
+        auto AsyncSetProperties(const DeviceProperties& props,
+                                const std::string& path,
+                                Duration timeout,
+                                CompletionToken&& token)
+        {
+            return AsyncSetProperties(props, path, timeout, ProgressOptions(), std::forward<CompletionToken>(token));
+        }
+
         /// @brief Initiate property update on selected FairMQ devices in this topology
         /// @param props Properties to set
         /// @param token Asio completion token
@@ -1657,40 +3252,348 @@ namespace odc::core
         dds::intercom_api::CIntercomService fDDSService;
         dds::intercom_api::CCustomCmd fDDSCustomCmd;
         dds::topology_api::CTopology fDDSTopo;
-        FairMQTopologyState fStateData;
-        FairMQTopologyStateIndex fStateIndex;
+        DeviceStateTable fStateTable;
+        FairMQTopologyStateIndex fStateIndex; ///< immutable after construction
 
+        /// protects the operation registries and the state change publisher bookkeeping, lock order: fMtx before
+        /// any fStateTable shard lock
         mutable std::unique_ptr<std::mutex> fMtx;
 
         std::unique_ptr<std::condition_variable> fStateChangeSubscriptionsCV;
         unsigned int fNumStateChangePublishers;
         boost::asio::steady_timer fHeartbeatsTimer;
         Duration fHeartbeatInterval;
+        /// deadlines of all pending operations, lock order: fMtx before the internal lock of the wheel
+        std::shared_ptr<TimerWheel> fTimers;
+        DeviceFailurePolicy fDeviceFailurePolicy; ///< guarded by fMtx
+        std::unordered_map<StateObserverId, std::shared_ptr<StateObserver>> fStateObservers; ///< guarded by fMtx
+        TransitionLatencies fLastTransitionLatencies; ///< of the last completed change state operation, guarded by fMtx
+        std::unique_ptr<CommandIngress> fIngress; ///< decodes and dispatches the incoming custom commands
 
         std::unordered_map<typename ChangeStateOp::Id, ChangeStateOp> fChangeStateOps;
         std::unordered_map<typename WaitForStateOp::Id, WaitForStateOp> fWaitForStateOps;
         std::unordered_map<typename SetPropertiesOp::Id, SetPropertiesOp> fSetPropertiesOps;
         std::unordered_map<typename GetPropertiesOp::Id, GetPropertiesOp> fGetPropertiesOps;
 
+        /// Inverted index dense state index -> ids of the pending operations covering that task, so that a state
+        /// update of one task only visits the operations it can affect instead of scanning all of them.
+        using TaskOpIndex = std::vector<std::vector<std::size_t>>;
+        TaskOpIndex fChangeStateOpsByTask;
+        TaskOpIndex fWaitForStateOpsByTask;
+
+        /// precondition: fMtx is locked.
+        static auto AddToTaskIndex(TaskOpIndex& index, std::size_t opId, const TaskSet& tasks) -> void
+        {
+            for (auto i = tasks.find_first(); i != TaskSet::npos; i = tasks.find_next(i))
+            {
+                index[i].push_back(opId);
+            }
+        }
+
+        /// precondition: fMtx is locked.
+        static auto RemoveFromTaskIndex(TaskOpIndex& index, std::size_t opId, const TaskSet& tasks) -> void
+        {
+            for (auto i = tasks.find_first(); i != TaskSet::npos; i = tasks.find_next(i))
+            {
+                auto& ids = index[i];
+                auto it = std::find(ids.begin(), ids.end(), opId);
+                if (it != ids.end())
+                {
+                    *it = ids.back();
+                    ids.pop_back();
+                }
+            }
+        }
+
+        /// Whether a pending operation covering the task waits for it to report the given state change.
+        /// precondition: fMtx is locked.
+        auto IsAwaited(const DDSTask::Id taskId, const DeviceState lastState, const DeviceState currentState) -> bool
+        {
+            auto const it = fStateIndex.find(taskId);
+            if (it == fStateIndex.end())
+            {
+                return false; // reported by ApplyStateChange
+            }
+            auto const index = static_cast<std::size_t>(it->second);
+            for (auto const id : fChangeStateOpsByTask.at(index))
+            {
+                if (fChangeStateOps.at(id).Awaits(index, currentState))
+                {
+                    return true;
+                }
+            }
+            for (auto const id : fWaitForStateOpsByTask.at(index))
+            {
+                if (fWaitForStateOps.at(id).Awaits(index, lastState, currentState))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /// Queue a state change for the observers of the device.
+        /// precondition: fMtx is locked.
+        auto NotifyStateObservers(const std::size_t index, DeviceStateChange change) -> void
+        {
+            if (fStateObservers.empty())
+            {
+                return;
+            }
+            change.timestamp = std::chrono::system_clock::now();
+            for (auto const& entry : fStateObservers)
+            {
+                if (entry.second->Covers(index))
+                {
+                    entry.second->Push(index, change);
+                }
+            }
+        }
+
+        /// A device crashed or entered Error state, the pending operations covering it react according to
+        /// fDeviceFailurePolicy.
+        /// precondition: fMtx is locked.
+        auto OnDeviceFailed(const std::size_t index) -> void
+        {
+            auto const& changeStateOps = fChangeStateOpsByTask.at(index);
+            for (auto i = changeStateOps.size(); i-- > 0;)
+            {
+                auto it = fChangeStateOps.find(changeStateOps[i]);
+                it->second.DeviceFailed(index, fDeviceFailurePolicy);
+                RetireIfCompleted(fChangeStateOps, it);
+            }
+            auto const& waitForStateOps = fWaitForStateOpsByTask.at(index);
+            for (auto i = waitForStateOps.size(); i-- > 0;)
+            {
+                auto it = fWaitForStateOps.find(waitForStateOps[i]);
+                it->second.DeviceFailed(index, fDeviceFailurePolicy);
+                RetireIfCompleted(fWaitForStateOps, it);
+            }
+        }
+
+        /// Apply the failure policy to devices of a new operation which have already failed before it was initiated.
+        /// precondition: fMtx is locked.
+        template <typename Op>
+        auto HandleFailedDevices(Op& op) -> void
+        {
+            for (auto const& entry : GetTasksInState(op.GetTasks(), DeviceState::Error))
+            {
+                op.DeviceFailed(entry.first, fDeviceFailurePolicy);
+            }
+        }
+
+        /// Register a new change state operation and index it by its tasks.
+        /// precondition: fMtx is locked.
+        /// @param handlerArgs completion handler, optionally preceded by a ChangeStateQuorum
+        template <typename... HandlerArgs>
+        auto AddChangeStateOp(std::vector<TopologyTransition> transitions,
+                              std::vector<DeviceState> targetStates,
+                              const std::string& path,
+                              Duration timeout,
+                              HandlerArgs&&... handlerArgs) -> typename decltype(fChangeStateOps)::iterator
+        {
+            typename ChangeStateOp::Id const id(uuidHash());
+            auto p = fChangeStateOps.emplace(std::piecewise_construct,
+                                             std::forward_as_tuple(id),
+                                             std::forward_as_tuple(id,
+                                                                   std::move(transitions),
+                                                                   std::move(targetStates),
+                                                                   GetTaskSet(path),
+                                                                   fStateTable,
+                                                                   timeout,
+                                                                   *fTimers,
+                                                                   MakeTimeoutHandler(fChangeStateOps, id),
+                                                                   *fMtx,
+                                                                   AsioBase<Executor, Allocator>::GetExecutor(),
+                                                                   AsioBase<Executor, Allocator>::GetAllocator(),
+                                                                   std::forward<HandlerArgs>(handlerArgs)...));
+            AddToTaskIndex(fChangeStateOpsByTask, id, p.first->second.GetTasks());
+            return p.first;
+        }
+
+        /// Retire a completed operation right away, so the registries and the task index only hold pending work.
+        /// precondition: fMtx is locked.
+        template <typename Ops>
+        auto RetireIfCompleted(Ops& ops, typename Ops::iterator it) -> void
+        {
+            if (!it->second.IsCompleted())
+            {
+                return;
+            }
+            if constexpr (std::is_same_v<Ops, decltype(fChangeStateOps)>)
+            {
+                RemoveFromTaskIndex(fChangeStateOpsByTask, it->first, it->second.GetTasks());
+                fLastTransitionLatencies = it->second.GetLatencies();
+            }
+            else if constexpr (std::is_same_v<Ops, decltype(fWaitForStateOps)>)
+            {
+                RemoveFromTaskIndex(fWaitForStateOpsByTask, it->first, it->second.GetTasks());
+            }
+            ops.erase(it);
+        }
+
+        /// Attach a progress reporter to a new operation and report the initial progress.
+        /// precondition: fMtx is locked.
+        template <typename Ops>
+        auto EnableProgress(Ops& ops, typename Ops::iterator it, const ProgressOptions& progress, TaskSet tasks)
+            -> void
+        {
+            if (!progress.handler)
+            {
+                return;
+            }
+            auto const id = it->first;
+            it->second.SetProgressReporter(
+                std::make_unique<ProgressReporter>(progress,
+                                                   std::move(tasks),
+                                                   fStateTable,
+                                                   *fTimers,
+                                                   [this, &ops, id]()
+                                                   {
+                                                       std::lock_guard<std::mutex> lk(*fMtx);
+                                                       auto opIt = ops.find(id);
+                                                       if (opIt != ops.end())
+                                                       {
+                                                           opIt->second.OnProgressTimer();
+                                                       }
+                                                   },
+                                                   AsioBase<Executor, Allocator>::GetExecutor()));
+            it->second.NotifyProgress();
+        }
+
+        /// Timeout callback for the timer wheel. The operation is looked up by id when the timer expires, it may have
+        /// completed or been erased in the meantime.
+        template <typename Ops>
+        auto MakeTimeoutHandler(Ops& ops, typename Ops::key_type id) -> TimerWheel::Callback
+        {
+            return [this, &ops, id]()
+            {
+                std::lock_guard<std::mutex> lk(*fMtx);
+                auto it = ops.find(id);
+                if (it != ops.end() && !it->second.IsCompleted())
+                {
+                    it->second.Timeout();
+                    RetireIfCompleted(ops, it);
+                }
+            };
+        }
+
+        /// Tasks selected by a path expression, resolved against the DDS topology once per topology and path
+        struct TaskSelection
+        {
+            std::vector<DDSTask> tasks;
+            TaskSet indices;
+            std::size_t exactIndex; ///< state index of the task with exactly the given path, TaskSet::npos if none
+        };
+        using TaskSelectionPtr = std::shared_ptr<const TaskSelection>;
+
+        /// Selection cache, path -> resolved tasks. The DDS topology of this object never changes, an updated
+        /// topology means a new BasicTopology and thus a fresh cache. Lock order: fMtx before fSelectionsMtx.
+        mutable std::unordered_map<std::string, TaskSelectionPtr> fSelections;
+        mutable std::unique_ptr<std::mutex> fSelectionsMtx = std::make_unique<std::mutex>();
+
+        /// @brief Runtime tasks of the DDS topology matching path, bypassing the selection cache
+        /// @param path Select a subset of FairMQ devices in this topology, empty selects all
+        auto MatchRuntimeTasks(const std::string& path) const
+        {
+            dds::topology_api::STopoRuntimeTask::FilterIteratorPair_t itPair;
+            if (path.empty())
+            {
+                itPair = fDDSTopo.getRuntimeTaskIterator(nullptr); // passing nullptr will get all tasks
+            }
+            else
+            {
+                itPair = fDDSTopo.getRuntimeTaskIteratorMatchingPath(path);
+            }
+            return boost::make_iterator_range(itPair.first, itPair.second);
+        }
+
+        /// @brief Resolve path into a task selection, cached per path
+        /// @param path Select a subset of FairMQ devices in this topology, empty selects all
+        auto GetTaskSelection(const std::string& path) const -> TaskSelectionPtr
+        {
+            {
+                std::lock_guard<std::mutex> lk(*fSelectionsMtx);
+                auto it = fSelections.find(path);
+                if (it != fSelections.end())
+                {
+                    return it->second;
+                }
+            }
+
+            auto selection = std::make_shared<TaskSelection>();
+            selection->indices.resize(fStateTable.Size());
+            selection->exactIndex = TaskSet::npos;
+
+            for (const auto& task : MatchRuntimeTasks(path))
+            {
+                // LOG(debug) << "Found task with id: " << task.first << ", "
+                //            << "Path: " << task.second.m_taskPath << ", "
+                //            << "Collection id: " << task.second.m_taskCollectionId << ", "
+                //            << "Name: " << task.second.m_task->getName() << "_" << task.second.m_taskIndex;
+                selection->tasks.emplace_back(task.first, task.second.m_taskCollectionId);
+                auto const index = static_cast<std::size_t>(fStateIndex.at(task.first));
+                selection->indices.set(index);
+                if (!path.empty() && task.second.m_taskPath == path)
+                {
+                    selection->exactIndex = index;
+                }
+            }
+
+            std::lock_guard<std::mutex> lk(*fSelectionsMtx);
+            if (fSelections.size() >= fMaxCachedSelections)
+            {
+                fSelections.clear();
+            }
+            return fSelections.emplace(path, std::move(selection)).first->second;
+        }
+
         auto makeTopologyState() -> void
         {
-            fStateData.reserve(GetTasks().size());
+            FairMQTopologyState stateData;
 
             int index = 0;
 
-            for (const auto& task : GetTasks())
+            for (const auto& task : MatchRuntimeTasks(""))
             {
-                fStateData.push_back(DeviceStatus{
-                    false, DeviceState::Undefined, DeviceState::Undefined, task.GetId(), task.GetCollectionId(), -1, -1 });
-                fStateIndex.emplace(task.GetId(), index);
+                stateData.push_back(DeviceStatus{ false,
+                                                  DeviceState::Undefined,
+                                                  DeviceState::Undefined,
+                                                  task.first,
+                                                  task.second.m_taskCollectionId,
+                                                  -1,
+                                                  -1 });
+                fStateIndex.emplace(task.first, index);
                 index++;
             }
+
+            fStateTable = DeviceStateTable(stateData);
+            fChangeStateOpsByTask.resize(fStateTable.Size());
+            fWaitForStateOpsByTask.resize(fStateTable.Size());
         }
 
-        /// precodition: fMtx is locked.
-        auto GetCurrentStateUnsafe() const -> FairMQTopologyState
+        /// @brief Select tasks matching the path as a set over the dense state indices
+        /// @param path Select a subset of FairMQ devices in this topology, empty selects all
+        auto GetTaskSet(const std::string& path) const -> TaskSet
+        {
+            return GetTaskSelection(path)->indices;
+        }
+
+        /// @brief Dense indices and ids of the given tasks which are currently in the given state
+        auto GetTasksInState(const TaskSet& tasks, DeviceState state) const
+            -> std::vector<std::pair<std::size_t, DDSTask::Id>>
         {
-            return fStateData;
+            std::vector<std::pair<std::size_t, DDSTask::Id>> result;
+            fStateTable.Read(
+                [&](const DeviceStateColumns& columns)
+                {
+                    auto const inState = tasks & DeviceStateColumns::EqualSet(columns.state, state);
+                    for (auto i = inState.find_first(); i != TaskSet::npos; i = inState.find_next(i))
+                    {
+                        result.emplace_back(i, columns.taskId[i]);
+                    }
+                });
+            return result;
         }
     };
 
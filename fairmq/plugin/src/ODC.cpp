@@ -13,6 +13,8 @@
 #include <boost/algorithm/string/split.hpp>
 #include <boost/asio/post.hpp>
 
+#include <algorithm>
+#include <array>
 #include <cstdlib>
 #include <initializer_list>
 #include <sstream>
@@ -35,6 +37,71 @@ namespace odc::plugins
         return ss.str();
     }
 
+    namespace
+    {
+        /// stable states of the main path through the device state machine, in order
+        const array<State, 7> walkStates = { { State::Idle,
+                                               State::InitializingDevice,
+                                               State::Initialized,
+                                               State::Bound,
+                                               State::DeviceReady,
+                                               State::Ready,
+                                               State::Running } };
+
+        /// transition from walkStates[i] to walkStates[i + 1]
+        const array<Transition, 6> walkUpTransitions = { { Transition::InitDevice,
+                                                           Transition::CompleteInit,
+                                                           Transition::Bind,
+                                                           Transition::Connect,
+                                                           Transition::InitTask,
+                                                           Transition::Run } };
+
+        auto WalkRank(State state) -> int
+        {
+            auto it = find(walkStates.begin(), walkStates.end(), state);
+            return it == walkStates.end() ? -1 : static_cast<int>(distance(walkStates.begin(), it));
+        }
+
+        auto IsWalkTarget(State state) -> bool
+        {
+            return state == State::Exiting || WalkRank(state) >= 0;
+        }
+
+        /// @brief Next transition on the way from the current to the target state
+        /// @return nothing if the device is in a transitional state, which it leaves on its own
+        auto NextTransitionTowards(State current, State target) -> optional<Transition>
+        {
+            int const cur = WalkRank(current);
+            if (cur < 0)
+            {
+                return nullopt;
+            }
+            if (target == State::Exiting)
+            {
+                if (current == State::Idle)
+                {
+                    return Transition::End;
+                }
+                target = State::Idle;
+            }
+            if (cur < WalkRank(target))
+            {
+                return walkUpTransitions.at(cur);
+            }
+            switch (current)
+            {
+                case State::Running:
+                    return Transition::Stop;
+                case State::Ready:
+                    return Transition::ResetTask;
+                case State::InitializingDevice: // has to complete the initialization before it can be reset
+                    return Transition::CompleteInit;
+                default:
+                    return Transition::ResetDevice;
+            }
+        }
+    } // namespace
+
     ODC::ODC(const string& name,
              const Plugin::Version version,
              const string& maintainer,
@@ -49,6 +116,9 @@ namespace odc::plugins
         , fExitingAckedByLastExternalController(false)
         , fUpdatesAllowed(false)
         , fWorkGuard(fWorkerQueue.get_executor())
+        , fTargetTransition(Transition::Auto)
+        , fTargetController(0)
+        , fStateWalkWorkGuard(fStateWalkQueue.get_executor())
     {
         try
         {
@@ -140,6 +210,7 @@ namespace odc::plugins
                     fLastState = fCurrentState;
                     fCurrentState = newState;
 
+                    string stateChange; // serialized on first use, the same message goes to every subscriber
                     lock_guard<mutex> lock{ fStateChangeSubscriberMutex };
                     for (auto it = fStateChangeSubscribers.cbegin(); it != fStateChangeSubscribers.end();)
                     {
@@ -156,11 +227,22 @@ namespace odc::plugins
                         {
                             LOG(debug) << "Publishing state-change: " << fLastState << "->" << fCurrentState << " to "
                                        << it->first;
-                            Cmds cmds(make<StateChange>(id, fDDSTaskId, fLastState, fCurrentState));
-                            fDDS.Send(cmds.Serialize(), to_string(it->first));
+                            if (stateChange.empty())
+                            {
+                                stateChange = Cmds(make<StateChange>(id, fDDSTaskId, fLastState, fCurrentState))
+                                                  .Serialize();
+                            }
+                            fDDS.Send(stateChange, to_string(it->first));
                             ++it;
                         }
                     }
+
+                    boost::asio::post(fStateWalkQueue, [this, newState]() { WalkToTargetState(newState); });
+                    if (newState == DeviceState::Exiting)
+                    {
+                        // only after the final post, the walk thread may drain the queue and return right away
+                        fStateWalkWorkGuard.reset();
+                    }
                 });
 
             StartWorkerThread();
@@ -186,6 +268,47 @@ namespace odc::plugins
     auto ODC::StartWorkerThread() -> void
     {
         fWorkerThread = thread([this]() { fWorkerQueue.run(); });
+        fStateWalkThread = thread([this]() { fStateWalkQueue.run(); });
+    }
+
+    auto ODC::WalkToTargetState(DeviceState state) -> void
+    {
+        using namespace odc::cc;
+        if (!fTargetState || state == fWalkedFrom)
+        {
+            return;
+        }
+
+        auto const report = [&](Result result, DeviceState current)
+        {
+            Cmds outCmds(make<TransitionStatus>(
+                GetProperty<string>("id"), fDDSTaskId, result, fTargetTransition, current));
+            fDDS.Send(outCmds.Serialize(), to_string(fTargetController));
+            fTargetState.reset();
+        };
+
+        if (state == *fTargetState)
+        {
+            report(Result::Ok, state);
+            return;
+        }
+        if (state == DeviceState::Error)
+        {
+            report(Result::Failure, state);
+            return;
+        }
+
+        auto const next = NextTransitionTowards(state, *fTargetState);
+        if (!next)
+        {
+            return; // transitional state, wait for the next state change
+        }
+        fTargetTransition = *next;
+        fWalkedFrom = state;
+        if (!ChangeDeviceState(*next))
+        {
+            report(Result::Failure, GetCurrentDeviceState());
+        }
     }
 
     auto ODC::WaitForExitingAck() -> void
@@ -417,16 +540,22 @@ namespace odc::plugins
             [id, this](const string& cmdStr, const string& cond, uint64_t senderId)
             {
                 // LOG(info) << "Received command: '" << cmdStr << "' from " << senderId;
-                odc::cc::Cmds inCmds;
-                inCmds.Deserialize(cmdStr);
-                for (const auto& cmd : inCmds)
+                try
+                {
+                    for (const auto cmd : odc::cc::CmdsView(cmdStr))
+                    {
+                        HandleCmd(id, cmd, cond, senderId);
+                    }
+                }
+                catch (const exception& e)
                 {
-                    HandleCmd(id, *cmd, cond, senderId);
+                    LOG(error) << "Failed to handle commands from " << senderId << ": " << e.what();
                 }
             });
     }
 
-    auto ODC::HandleCmd(const string& id, odc::cc::Cmd& cmd, const string& cond, uint64_t senderId) -> void
+    auto ODC::HandleCmd(const string& id, const odc::cc::CmdView& cmd, const string& cond, uint64_t senderId)
+        -> void
     {
         using namespace fair::mq;
         using namespace odc::cc;
@@ -440,23 +569,49 @@ namespace odc::plugins
             break;
             case Type::change_state:
             {
-                Transition transition = static_cast<ChangeState&>(cmd).GetTransition();
-                if (ChangeDeviceState(transition))
+                Transition transition = cmd.GetTransition();
+                // An explicit transition takes over from a pending walk. Requested on the walk queue, so that no walk
+                // step already queued there runs after it.
+                boost::asio::post(fStateWalkQueue,
+                                  [this, id, transition, senderId]()
+                                  {
+                                      fTargetState.reset();
+                                      Result const result{ ChangeDeviceState(transition) ? Result::Ok
+                                                                                         : Result::Failure };
+                                      Cmds outCmds(make<TransitionStatus>(
+                                          id, fDDSTaskId, result, transition, GetCurrentDeviceState()));
+                                      fDDS.Send(outCmds.Serialize(), to_string(senderId));
+                                  });
                 {
-                    Cmds outCmds(
-                        make<TransitionStatus>(id, fDDSTaskId, Result::Ok, transition, GetCurrentDeviceState()));
-                    fDDS.Send(outCmds.Serialize(), to_string(senderId));
-                }
-                else
-                {
-                    Cmds outCmds(
-                        make<TransitionStatus>(id, fDDSTaskId, Result::Failure, transition, GetCurrentDeviceState()));
-                    fDDS.Send(outCmds.Serialize(), to_string(senderId));
+                    lock_guard<mutex> lock{ fStateChangeSubscriberMutex };
+                    fLastExternalController = senderId;
                 }
+            }
+            break;
+            case Type::change_state_to:
+            {
+                DeviceState const target = cmd.GetTargetState();
                 {
                     lock_guard<mutex> lock{ fStateChangeSubscriberMutex };
                     fLastExternalController = senderId;
                 }
+                if (!IsWalkTarget(target))
+                {
+                    LOG(error) << "Cannot walk the state machine to state " << target;
+                    Cmds outCmds(make<TransitionStatus>(
+                        id, fDDSTaskId, Result::Failure, Transition::Auto, GetCurrentDeviceState()));
+                    fDDS.Send(outCmds.Serialize(), to_string(senderId));
+                    break;
+                }
+                boost::asio::post(fStateWalkQueue,
+                                  [this, target, senderId]()
+                                  {
+                                      fTargetState = target;
+                                      fWalkedFrom.reset();
+                                      fTargetTransition = Transition::Auto;
+                                      fTargetController = senderId;
+                                      WalkToTargetState(GetCurrentDeviceState());
+                                  });
             }
             break;
             case Type::dump_config:
@@ -484,9 +639,8 @@ namespace odc::plugins
             break;
             case Type::subscribe_to_state_change:
             {
-                auto _cmd = static_cast<cc::SubscribeToStateChange&>(cmd);
                 lock_guard<mutex> lock{ fStateChangeSubscriberMutex };
-                fStateChangeSubscribers.emplace(senderId, make_pair(chrono::steady_clock::now(), _cmd.GetInterval()));
+                fStateChangeSubscribers.emplace(senderId, make_pair(chrono::steady_clock::now(), cmd.GetInterval()));
 
                 LOG(debug) << "Publishing state-change: " << fLastState << "->" << fCurrentState << " to " << senderId;
 
@@ -500,9 +654,8 @@ namespace odc::plugins
             {
                 try
                 {
-                    auto _cmd = static_cast<cc::SubscriptionHeartbeat&>(cmd);
                     lock_guard<mutex> lock{ fStateChangeSubscriberMutex };
-                    fStateChangeSubscribers.at(senderId) = make_pair(chrono::steady_clock::now(), _cmd.GetInterval());
+                    fStateChangeSubscribers.at(senderId) = make_pair(chrono::steady_clock::now(), cmd.GetInterval());
                 }
                 catch (out_of_range& oor)
                 {
@@ -523,13 +676,12 @@ namespace odc::plugins
             break;
             case Type::get_properties:
             {
-                auto _cmd = static_cast<cc::GetProperties&>(cmd);
-                auto const request_id(_cmd.GetRequestId());
+                auto const request_id(cmd.GetRequestId());
                 auto result(Result::Ok);
                 vector<pair<string, string>> props;
                 try
                 {
-                    for (auto const& prop : GetPropertiesAsString(_cmd.GetQuery()))
+                    for (auto const& prop : GetPropertiesAsString(string(cmd.GetQuery())))
                     {
                         props.push_back({ prop.first, prop.second });
                     }
@@ -545,15 +697,15 @@ namespace odc::plugins
             break;
             case Type::set_properties:
             {
-                auto _cmd(static_cast<cc::SetProperties&>(cmd));
-                auto const request_id(_cmd.GetRequestId());
+                auto const request_id(cmd.GetRequestId());
                 auto result(Result::Ok);
                 try
                 {
                     fair::mq::Properties props;
-                    for (auto const& prop : _cmd.GetProps())
+                    for (size_t i = 0; i < cmd.GetNumProps(); ++i)
                     {
-                        props.insert({ prop.first, fair::mq::Property(prop.second) });
+                        auto const prop = cmd.GetProp(i);
+                        props.insert({ string(prop.first), fair::mq::Property(string(prop.second)) });
                     }
                     // TODO Handle builtin keys with different value type than string
                     SetProperties(props);
@@ -590,6 +742,12 @@ namespace odc::plugins
         {
             fWorkerThread.join();
         }
+
+        fStateWalkWorkGuard.reset();
+        if (fStateWalkThread.joinable())
+        {
+            fStateWalkThread.join();
+        }
     }
 
 } // namespace odc::plugins
@@ -27,6 +27,7 @@
 #include <condition_variable>
 #include <map>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -147,7 +148,9 @@ namespace odc::plugins
         auto SubscribeForConnectingChannels() -> void;
         auto PublishBoundChannels() -> void;
         auto SubscribeForCustomCommands() -> void;
-        auto HandleCmd(const std::string& id, cc::Cmd& cmd, const std::string& cond, uint64_t senderId) -> void;
+        auto HandleCmd(const std::string& id, const cc::CmdView& cmd, const std::string& cond, uint64_t senderId)
+            -> void;
+        auto WalkToTargetState(DeviceState state) -> void;
 
         DDSSubscription fDDS;
         size_t fDDSTaskId;
@@ -176,6 +179,16 @@ namespace odc::plugins
         std::thread fWorkerThread;
         boost::asio::io_context fWorkerQueue;
         boost::asio::executor_work_guard<boost::asio::executor> fWorkGuard;
+
+        // Walk of the state machine requested by cc::ChangeStateTo. Runs on its own queue, the worker queue can be
+        // blocked until the device is bound. The members below are only accessed from fStateWalkQueue.
+        std::optional<DeviceState> fTargetState;
+        std::optional<DeviceState> fWalkedFrom;     ///< state the last transition of the walk was requested in
+        DeviceStateTransition fTargetTransition;    ///< last transition of the walk
+        uint64_t fTargetController;                 ///< sender of the ChangeStateTo command
+        std::thread fStateWalkThread;
+        boost::asio::io_context fStateWalkQueue;
+        boost::asio::executor_work_guard<boost::asio::executor> fStateWalkWorkGuard;
     };
 
     inline fair::mq::Plugin::ProgOptions ODCPluginProgramOptions()
@@ -21,6 +21,11 @@ void CGrpcAsyncService::setTimeout(const std::chrono::seconds& _timeout)
     m_service->setTimeout(_timeout);
 }
 
+void CGrpcAsyncService::setDeviceWalk(bool _deviceWalk)
+{
+    m_service->setDeviceWalk(_deviceWalk);
+}
+
 void CGrpcAsyncService::registerResourcePlugins(const CDDSSubmit::PluginMap_t& _pluginMap)
 {
     m_service->registerResourcePlugins(_pluginMap);
@@ -21,6 +21,7 @@ namespace odc::grpc
 
         void run(const std::string& _host);
         void setTimeout(const std::chrono::seconds& _timeout);
+        void setDeviceWalk(bool _deviceWalk);
         void registerResourcePlugins(const odc::core::CDDSSubmit::PluginMap_t& _pluginMap);
 
       private:
@@ -22,6 +22,11 @@ void CGrpcService::setTimeout(const std::chrono::seconds& _timeout)
     m_service->setTimeout(_timeout);
 }
 
+void CGrpcService::setDeviceWalk(bool _deviceWalk)
+{
+    m_service->setDeviceWalk(_deviceWalk);
+}
+
 void CGrpcService::registerResourcePlugins(const CDDSSubmit::PluginMap_t& _pluginMap)
 {
     m_service->registerResourcePlugins(_pluginMap);
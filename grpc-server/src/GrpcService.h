@@ -20,6 +20,7 @@ namespace odc::grpc
         CGrpcService();
 
         void setTimeout(const std::chrono::seconds& _timeout);
+        void setDeviceWalk(bool _deviceWalk);
         void registerResourcePlugins(const odc::core::CDDSSubmit::PluginMap_t& _pluginMap);
 
         ::grpc::Status Initialize(::grpc::ServerContext* context,
@@ -31,6 +31,11 @@ void CGrpcSyncService::setTimeout(const std::chrono::seconds& _timeout)
     m_service->setTimeout(_timeout);
 }
 
+void CGrpcSyncService::setDeviceWalk(bool _deviceWalk)
+{
+    m_service->setDeviceWalk(_deviceWalk);
+}
+
 void CGrpcSyncService::registerResourcePlugins(const CDDSSubmit::PluginMap_t& _pluginMap)
 {
     m_service->registerResourcePlugins(_pluginMap);
@@ -30,6 +30,7 @@ int main(int argc, char** argv)
     {
         bool sync;
         size_t timeout;
+        bool deviceWalk;
         string host;
         CLogger::SConfig logConfig;
         CDDSSubmit::PluginMap_t pluginMap;
@@ -40,6 +41,7 @@ int main(int argc, char** argv)
         CCliHelper::addVersionOptions(options);
         CCliHelper::addSyncOptions(options, sync);
         CCliHelper::addTimeoutOptions(options, timeout);
+        CCliHelper::addDeviceWalkOptions(options, deviceWalk);
         CCliHelper::addHostOptions(options, host);
         CCliHelper::addLogOptions(options, logConfig);
         CCliHelper::addResourcePluginOptions(options, pluginMap);
@@ -79,6 +81,7 @@ int main(int argc, char** argv)
         {
             odc::grpc::CGrpcSyncService server;
             server.setTimeout(chrono::seconds(timeout));
+            server.setDeviceWalk(deviceWalk);
             server.registerResourcePlugins(pluginMap);
             server.run(host);
         }
@@ -86,6 +89,7 @@ int main(int argc, char** argv)
         {
             odc::grpc::CGrpcAsyncService server;
             server.setTimeout(chrono::seconds(timeout));
+            server.setDeviceWalk(deviceWalk);
             server.registerResourcePlugins(pluginMap);
             server.run(host);
         }
@@ -0,0 +1,142 @@
+/********************************************************************************
+ * Copyright (C) 2019-2021 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#define BOOST_TEST_MODULE(odc_core)
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/included/unit_test.hpp>
+
+#include "ControlService.h"
+#include "Error.h"
+#include "Topology.h"
+#include "TransitionHistory.h"
+#include "odc_fairmq_lib-fixtures.h"
+
+#include <chrono>
+
+using namespace boost::unit_test;
+using namespace odc::core;
+using namespace std::chrono_literals;
+
+BOOST_AUTO_TEST_SUITE(transition_history);
+
+BOOST_AUTO_TEST_CASE(min_samples)
+{
+    CTransitionHistory history;
+    for (int i = 0; i < 4; ++i)
+    {
+        history.record("STOP", "", 1s);
+        BOOST_CHECK_EQUAL(history.timeout("STOP", "", 30s).count(), 30000);
+    }
+    history.record("STOP", "", 1s);
+    BOOST_CHECK_EQUAL(history.timeout("STOP", "", 30s).count(), 5000);
+}
+
+BOOST_AUTO_TEST_CASE(p99)
+{
+    CTransitionHistory::SConfig config;
+    config.m_historySize = 200;
+    config.m_minTimeout = 0ms;
+    CTransitionHistory history(config);
+    // 1..200 ms, nearest rank p99 is the 198th duration
+    for (int i = 200; i > 0; --i)
+    {
+        history.record("RUN", "", std::chrono::milliseconds(i));
+    }
+    BOOST_CHECK_EQUAL(history.timeout("RUN", "", 30s).count(), 3 * 198);
+}
+
+BOOST_AUTO_TEST_CASE(history_size)
+{
+    CTransitionHistory::SConfig config;
+    config.m_historySize = 5;
+    config.m_minTimeout = 0ms;
+    CTransitionHistory history(config);
+    history.record("RUN", "", 1000ms);
+    for (int i = 0; i < 5; ++i)
+    {
+        history.record("RUN", "", 100ms);
+    }
+    // the oldest, slowest duration has been dropped
+    BOOST_CHECK_EQUAL(history.timeout("RUN", "", 30s).count(), 300);
+}
+
+BOOST_AUTO_TEST_CASE(floor_and_cap)
+{
+    CTransitionHistory history;
+    for (int i = 0; i < 5; ++i)
+    {
+        history.record("STOP", "", 10ms);
+        history.record("RUN", "", 20s);
+    }
+    BOOST_CHECK_EQUAL(history.timeout("STOP", "", 30s).count(), 5000);
+    BOOST_CHECK_EQUAL(history.timeout("RUN", "", 30s).count(), 30000);
+    // the configured timeout caps the floor as well
+    BOOST_CHECK_EQUAL(history.timeout("STOP", "", 2s).count(), 2000);
+}
+
+BOOST_AUTO_TEST_CASE(per_path)
+{
+    CTransitionHistory history;
+    for (int i = 0; i < 5; ++i)
+    {
+        history.record("STOP", "main/Sampler.*", 10ms);
+    }
+    BOOST_CHECK_EQUAL(history.timeout("STOP", "main/Sampler.*", 30s).count(), 5000);
+    // a request on another path is not bound by the history of a small selection
+    BOOST_CHECK_EQUAL(history.timeout("STOP", "", 30s).count(), 30000);
+    BOOST_CHECK_EQUAL(history.timeout("RUN", "main/Sampler.*", 30s).count(), 30000);
+
+    history.forget("STOP", "main/Sampler.*");
+    BOOST_CHECK_EQUAL(history.timeout("STOP", "main/Sampler.*", 30s).count(), 30000);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // transition_history
+
+BOOST_AUTO_TEST_SUITE(control_service);
+
+BOOST_AUTO_TEST_CASE(configure_with_failed_device)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    CControlService service;
+    service.setTimeout(20s);
+    partitionID_t const partition("configure_with_failed_device");
+    // attaching to the session with the active topology creates the FairMQ topology of the partition
+    auto const init{ service.execInitialize(partition, SInitializeParams(to_string(f.mDDSSession->getSessionID()))) };
+    BOOST_REQUIRE_EQUAL(init.m_error.m_code, std::error_code());
+
+    {
+        // crash the processors, bring the other devices back to Idle
+        Topology topo(f.mDDSTopo, f.mDDSSession);
+        BOOST_REQUIRE_EQUAL(topo.ChangeState(TopologyTransition::InitDevice).first, std::error_code());
+        BOOST_REQUIRE_EQUAL(topo.ChangeState(TopologyTransition::CompleteInit).first, std::error_code());
+        try
+        {
+            topo.SetProperties({ { "crash", "yes" } }, ".*/Processor.*", 10ms);
+        }
+        catch (std::system_error const& e)
+        {
+            BOOST_TEST_MESSAGE("system_error >> code: " << e.code() << ", what: " << e.what());
+        }
+        BOOST_REQUIRE_EQUAL(topo.WaitForState(DeviceState::Error, ".*/Processor.*", 30s), std::error_code());
+        for (auto const path : { ".*/Sampler.*", ".*/Sink.*" })
+        {
+            BOOST_REQUIRE_EQUAL(topo.ChangeState(TopologyTransition::ResetDevice, path).first, std::error_code());
+        }
+    }
+
+    // fails right away instead of waiting for the timeout
+    auto const result{ service.execConfigure(partition, SDeviceParams("", false)) };
+    BOOST_CHECK_EQUAL(result.m_statusCode, EStatusCode::error);
+    BOOST_CHECK_EQUAL(result.m_error.m_code, MakeErrorCode(ErrorCode::FairMQChangeStateFailed));
+    BOOST_CHECK_LT(result.m_execTime, 20000);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // control_service
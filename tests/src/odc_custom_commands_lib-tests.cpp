@@ -33,6 +33,7 @@ BOOST_AUTO_TEST_CASE(construction)
     Cmds getPropertiesCmds(make<GetProperties>(66, "k[12]"));
     Cmds setPropertiesCmds(make<SetProperties>(42, props));
     Cmds subscriptionHeartbeatCmds(make<SubscriptionHeartbeat>(60000));
+    Cmds changeStateToCmds(make<ChangeStateTo>(State::Ready));
     Cmds currentStateCmds(make<CurrentState>("somedeviceid", State::Running));
     Cmds transitionStatusCmds(
         make<TransitionStatus>("somedeviceid", 123456, Result::Ok, Transition::Stop, State::Running));
@@ -42,6 +43,8 @@ BOOST_AUTO_TEST_CASE(construction)
     Cmds stateChangeCmds(make<StateChange>("somedeviceid", 123456, State::Running, State::Ready));
     Cmds propertiesCmds(make<Properties>("somedeviceid", 66, Result::Ok, props));
     Cmds propertiesSetCmds(make<PropertiesSet>("somedeviceid", 42, Result::Ok));
+    Cmds stateChangeBatchCmds(make<StateChangeBatch>(
+        std::vector<StateChangeEntry>({ { 123456, State::Running, State::Ready, 1000 } })));
 
     BOOST_TEST(checkStateCmds.At(0).GetType() == Type::check_state);
     BOOST_TEST(changeStateCmds.At(0).GetType() == Type::change_state);
@@ -59,6 +62,8 @@ BOOST_AUTO_TEST_CASE(construction)
     BOOST_TEST(static_cast<SetProperties&>(setPropertiesCmds.At(0)).GetProps() == props);
     BOOST_TEST(subscriptionHeartbeatCmds.At(0).GetType() == Type::subscription_heartbeat);
     BOOST_TEST(static_cast<SubscriptionHeartbeat&>(subscriptionHeartbeatCmds.At(0)).GetInterval() == 60000);
+    BOOST_TEST(changeStateToCmds.At(0).GetType() == Type::change_state_to);
+    BOOST_TEST(static_cast<ChangeStateTo&>(changeStateToCmds.At(0)).GetTargetState() == State::Ready);
     BOOST_TEST(currentStateCmds.At(0).GetType() == Type::current_state);
     BOOST_TEST(static_cast<CurrentState&>(currentStateCmds.At(0)).GetDeviceId() == "somedeviceid");
     BOOST_TEST(static_cast<CurrentState&>(currentStateCmds.At(0)).GetCurrentState() == State::Running);
@@ -95,6 +100,9 @@ BOOST_AUTO_TEST_CASE(construction)
     BOOST_TEST(static_cast<PropertiesSet&>(propertiesSetCmds.At(0)).GetDeviceId() == "somedeviceid");
     BOOST_TEST(static_cast<PropertiesSet&>(propertiesSetCmds.At(0)).GetRequestId() == 42);
     BOOST_TEST(static_cast<PropertiesSet&>(propertiesSetCmds.At(0)).GetResult() == Result::Ok);
+    BOOST_TEST(stateChangeBatchCmds.At(0).GetType() == Type::state_change_batch);
+    BOOST_TEST(static_cast<StateChangeBatch&>(stateChangeBatchCmds.At(0)).GetStateChanges().size() == 1);
+    BOOST_TEST(static_cast<StateChangeBatch&>(stateChangeBatchCmds.At(0)).GetStateChanges()[0].taskId == 123456);
 }
 
 void fillCommands(Cmds& cmds)
@@ -110,6 +118,7 @@ void fillCommands(Cmds& cmds)
     cmds.Add<GetProperties>(66, "k[12]");
     cmds.Add<SetProperties>(42, props);
     cmds.Add<SubscriptionHeartbeat>(60000);
+    cmds.Add<ChangeStateTo>(State::Ready);
     cmds.Add<CurrentState>("somedeviceid", State::Running);
     cmds.Add<TransitionStatus>("somedeviceid", 123456, Result::Ok, Transition::Stop, State::Running);
     cmds.Add<Config>("somedeviceid", "someconfig");
@@ -118,11 +127,13 @@ void fillCommands(Cmds& cmds)
     cmds.Add<StateChange>("somedeviceid", 123456, State::Running, State::Ready);
     cmds.Add<Properties>("somedeviceid", 66, Result::Ok, props);
     cmds.Add<PropertiesSet>("somedeviceid", 42, Result::Ok);
+    cmds.Add<StateChangeBatch>(std::vector<StateChangeEntry>(
+        { { 123456, State::Running, State::Ready, 1000 }, { 123457, State::Ready, State::ResettingTask, 2000 } }));
 }
 
 void checkCommands(Cmds& cmds)
 {
-    BOOST_TEST(cmds.Size() == 17);
+    BOOST_TEST(cmds.Size() == 19);
 
     int count = 0;
     auto const props(std::vector<std::pair<std::string, std::string>>({ { "k1", "v1" }, { "k2", "v2" } }));
@@ -165,6 +176,10 @@ void checkCommands(Cmds& cmds)
                 ++count;
                 BOOST_TEST(static_cast<SubscriptionHeartbeat&>(*cmd).GetInterval() == 60000);
                 break;
+            case Type::change_state_to:
+                ++count;
+                BOOST_TEST(static_cast<ChangeStateTo&>(*cmd).GetTargetState() == State::Ready);
+                break;
             case Type::current_state:
                 ++count;
                 BOOST_TEST(static_cast<CurrentState&>(*cmd).GetDeviceId() == "somedeviceid");
@@ -215,13 +230,46 @@ void checkCommands(Cmds& cmds)
                 BOOST_TEST(static_cast<PropertiesSet&>(*cmd).GetRequestId() == 42);
                 BOOST_TEST(static_cast<PropertiesSet&>(*cmd).GetResult() == Result::Ok);
                 break;
+            case Type::state_change_batch:
+            {
+                ++count;
+                auto const& stateChanges = static_cast<StateChangeBatch&>(*cmd).GetStateChanges();
+                BOOST_TEST(stateChanges.size() == 2);
+                BOOST_TEST(stateChanges.at(0).taskId == 123456);
+                BOOST_TEST(stateChanges.at(0).lastState == State::Running);
+                BOOST_TEST(stateChanges.at(0).currentState == State::Ready);
+                BOOST_TEST(stateChanges.at(0).timestamp == 1000);
+                BOOST_TEST(stateChanges.at(1).taskId == 123457);
+                BOOST_TEST(stateChanges.at(1).lastState == State::Ready);
+                BOOST_TEST(stateChanges.at(1).currentState == State::ResettingTask);
+                BOOST_TEST(stateChanges.at(1).timestamp == 2000);
+            }
+            break;
             default:
                 BOOST_TEST(false);
                 break;
         }
     }
 
-    BOOST_TEST(count == 17);
+    BOOST_TEST(count == 19);
+}
+
+BOOST_AUTO_TEST_CASE(encoded)
+{
+    // cached buffers equal a fresh serialization and are encoded only once per set of arguments
+    BOOST_TEST(EncodedCmds::ChangeState(Transition::Run) == Cmds(make<ChangeState>(Transition::Run)).Serialize());
+    BOOST_TEST(EncodedCmds::ChangeStateTo(State::Ready) == Cmds(make<ChangeStateTo>(State::Ready)).Serialize());
+    BOOST_TEST(EncodedCmds::SubscriptionHeartbeat(600) == Cmds(make<SubscriptionHeartbeat>(600)).Serialize());
+    BOOST_TEST(EncodedCmds::UnsubscribeFromStateChange()
+               == Cmds(make<UnsubscribeFromStateChange>()).Serialize());
+    BOOST_TEST(&EncodedCmds::ChangeState(Transition::Run) == &EncodedCmds::ChangeState(Transition::Run));
+    BOOST_TEST(&EncodedCmds::ChangeState(Transition::Run) != &EncodedCmds::ChangeState(Transition::Stop));
+    BOOST_TEST(EncodedCmds::SubscriptionHeartbeat(600) != EncodedCmds::SubscriptionHeartbeat(700));
+
+    Cmds inCmds;
+    inCmds.Deserialize(EncodedCmds::SubscribeToStateChange(600));
+    BOOST_TEST(inCmds.At(0).GetType() == Type::subscribe_to_state_change);
+    BOOST_TEST(static_cast<SubscribeToStateChange&>(inCmds.At(0)).GetInterval() == 600);
 }
 
 BOOST_AUTO_TEST_CASE(serialization_binary)
@@ -246,4 +294,82 @@ BOOST_AUTO_TEST_CASE(serialization_json)
     checkCommands(inCmds);
 }
 
+BOOST_AUTO_TEST_CASE(serialization_json_reuse)
+{
+    // the schema is parsed once, the JSON parser of a thread is reused and recovers from malformed input
+    Cmds outCmds;
+    fillCommands(outCmds);
+    std::string const json(outCmds.Serialize(Format::JSON));
+    std::string const small(
+        Cmds(make<StateChange>("somedeviceid", 123456, State::Running, State::Ready)).Serialize(Format::JSON));
+
+    Cmds inCmds;
+    inCmds.Deserialize(small, Format::JSON);
+    BOOST_TEST(inCmds.Size() == 1);
+    BOOST_TEST(static_cast<StateChange&>(inCmds.At(0)).GetDeviceId() == "somedeviceid");
+    BOOST_CHECK_THROW(inCmds.Deserialize("{ commands: [ { command_id: ", Format::JSON), Cmds::CommandFormatError);
+    inCmds.Deserialize(json, Format::JSON);
+    checkCommands(inCmds);
+    inCmds.Deserialize(json, Format::JSON);
+    checkCommands(inCmds);
+    BOOST_TEST(outCmds.Serialize(Format::JSON) == json);
+}
+
+BOOST_AUTO_TEST_CASE(serialization_reuse)
+{
+    // the builder is reused by consecutive serializations on a thread, also across a large message
+    std::vector<std::pair<std::string, std::string>> const bigProps({ { "big", std::string(100000, 'x') } });
+    std::string const big(Cmds(make<SetProperties>(1, bigProps)).Serialize());
+    std::string const small(Cmds(make<StateChange>("somedeviceid", 123456, State::Running, State::Ready)).Serialize());
+    Cmds outCmds;
+    fillCommands(outCmds);
+    std::string const all(outCmds.Serialize());
+
+    Cmds inCmds;
+    inCmds.Deserialize(big);
+    BOOST_TEST(static_cast<SetProperties&>(inCmds.At(0)).GetProps() == bigProps);
+    inCmds.Deserialize(small);
+    BOOST_TEST(static_cast<StateChange&>(inCmds.At(0)).GetDeviceId() == "somedeviceid");
+    inCmds.Deserialize(all);
+    checkCommands(inCmds);
+}
+
+BOOST_AUTO_TEST_CASE(view)
+{
+    Cmds outCmds;
+    fillCommands(outCmds);
+    std::string const buffer(outCmds.Serialize());
+
+    CmdsView const view(buffer);
+    BOOST_TEST(view.Size() == 19);
+    Cmds inCmds;
+    for (auto const cmd : view)
+    {
+        inCmds.Add(cmd.ToCmd());
+    }
+    checkCommands(inCmds);
+
+    // strings point into the buffer
+    auto const stateChange = view.At(15);
+    BOOST_TEST(stateChange.GetType() == Type::state_change);
+    BOOST_TEST(stateChange.GetDeviceId() == "somedeviceid");
+    BOOST_TEST(stateChange.GetDeviceId().data() >= buffer.data());
+    BOOST_TEST(stateChange.GetDeviceId().data() < buffer.data() + buffer.size());
+    BOOST_TEST(stateChange.GetTaskId() == 123456);
+    BOOST_TEST(stateChange.GetLastState() == State::Running);
+    BOOST_TEST(stateChange.GetCurrentState() == State::Ready);
+    auto const properties = view.At(16);
+    BOOST_TEST(properties.GetNumProps() == 2);
+    BOOST_TEST(properties.GetProp(1).first == "k2");
+    BOOST_TEST(properties.GetProp(1).second == "v2");
+    BOOST_TEST(view.At(0).GetNumProps() == 0);
+    auto const stateChangeBatch = view.At(18);
+    BOOST_TEST(stateChangeBatch.GetNumStateChanges() == 2);
+    BOOST_TEST(stateChangeBatch.GetStateChange(1).taskId == 123457);
+    BOOST_TEST(stateChangeBatch.GetStateChange(1).currentState == State::ResettingTask);
+    BOOST_TEST(view.At(0).GetNumStateChanges() == 0);
+
+    BOOST_CHECK_THROW(CmdsView(std::string_view("garbage")), Cmds::CommandFormatError);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
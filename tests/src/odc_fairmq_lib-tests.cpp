@@ -8,11 +8,18 @@
 
 #include "AsioAsyncOp.h"
 #include "AsioBase.h"
+#include "CommandIngress.h"
+#include "StateKernels.h"
+#include "TimerWheel.h"
 #include "Topology.h"
 #include "odc_fairmq_lib-fixtures.h"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <boost/asio.hpp>
+#include <regex>
+#include <set>
 #include <thread>
 
 using namespace boost::unit_test;
@@ -134,6 +141,33 @@ void full_device_lifecycle(Functor&& functor)
     }
 }
 
+/// Bring all devices to Initialized and crash the processors, which are Error afterwards
+void crash_processors(Topology& topo)
+{
+    using namespace std::chrono_literals;
+    BOOST_REQUIRE_EQUAL(topo.ChangeState(TopologyTransition::InitDevice).first, std::error_code());
+    BOOST_REQUIRE_EQUAL(topo.ChangeState(TopologyTransition::CompleteInit).first, std::error_code());
+    try {
+        topo.SetProperties({ { "crash", "yes" } }, ".*/Processor.*", 10ms);
+    } catch (std::system_error const& e) {
+        BOOST_TEST_MESSAGE("system_error >> code: " << e.code() << ", what: " << e.what());
+    }
+    BOOST_REQUIRE_EQUAL(topo.WaitForState(DeviceState::Error, ".*/Processor.*", 30s), std::error_code());
+}
+
+/// Check that the processors are in Error state and all other devices in the given state
+void check_all_but_processors_in(Topology& topo, const FairMQTopologyState& state, DeviceState expected)
+{
+    auto const processors = topo.GetTasks(".*/Processor.*");
+    for (auto const& device : state)
+    {
+        bool const isProcessor = std::any_of(processors.cbegin(),
+                                             processors.cend(),
+                                             [&](const DDSTask& task) { return task.GetId() == device.taskId; });
+        BOOST_CHECK_EQUAL(device.state, isProcessor ? DeviceState::Error : expected);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE(topology);
 
 BOOST_AUTO_TEST_CASE(construction)
@@ -338,6 +372,141 @@ BOOST_AUTO_TEST_CASE(async_change_state_timeout)
     f.mIoContext.run();
 }
 
+BOOST_AUTO_TEST_CASE(async_change_state_progress)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    Topology topo(f.mIoContext.get_executor(), f.mDDSTopo, f.mDDSSession);
+    auto const numDevices = topo.GetCurrentState().size();
+    std::size_t numReports = 0;
+    ProgressOptions progress;
+    progress.interval = std::chrono::milliseconds(10);
+    progress.handler = [&](const OperationProgress& p)
+    {
+        ++numReports;
+        BOOST_CHECK_EQUAL(p.total, numDevices);
+        BOOST_CHECK_LE(p.done, p.total);
+        std::size_t numInStates = 0;
+        for (auto const& entry : p.states)
+        {
+            numInStates += entry.second;
+        }
+        BOOST_CHECK_EQUAL(numInStates, numDevices);
+    };
+    topo.AsyncChangeState(TopologyTransition::InitDevice,
+                          "",
+                          std::chrono::milliseconds(0),
+                          progress,
+                          [](std::error_code ec, FairMQTopologyState)
+                          {
+                              BOOST_TEST_MESSAGE(ec);
+                              BOOST_CHECK_EQUAL(ec, std::error_code());
+                          });
+
+    f.mIoContext.run();
+    // the initial report is always sent, the later ones are coalesced
+    BOOST_CHECK_GE(numReports, 1);
+    BOOST_CHECK_LE(numReports, numDevices + 1);
+}
+
+BOOST_AUTO_TEST_CASE(async_change_state_quorum)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    Topology topo(f.mDDSTopo, f.mDDSSession);
+    // hold the processors back, they never reach the target state
+    crash_processors(topo);
+    topo.SetDeviceFailurePolicy(DeviceFailurePolicy::Wait);
+    auto const numDevices = topo.GetCurrentState().size();
+    auto const processors = topo.GetTasks(".*/Processor.*");
+    BOOST_REQUIRE(!processors.empty());
+
+    // only the device count is set, the other criteria are ignored
+    ChangeStateQuorum quorum;
+    quorum.minDevices = numDevices - processors.size();
+    SharedSemaphore blocker;
+    std::error_code ec;
+    FairMQTopologyState state;
+    std::vector<DDSTask::Id> laggards;
+    topo.AsyncChangeState(TopologyTransition::Bind,
+                          "",
+                          std::chrono::seconds(30),
+                          quorum,
+                          [&, blocker](std::error_code _ec,
+                                       FairMQTopologyState _state,
+                                       std::vector<DDSTask::Id> _laggards) mutable
+                          {
+                              ec = _ec;
+                              state = std::move(_state);
+                              laggards = std::move(_laggards);
+                              blocker.Signal();
+                          });
+    blocker.Wait();
+
+    BOOST_TEST_MESSAGE(ec);
+    BOOST_CHECK_EQUAL(ec, std::error_code());
+    BOOST_CHECK_EQUAL(state.size(), numDevices);
+    check_all_but_processors_in(topo, state, DeviceState::Bound);
+
+    // the laggards are exactly the devices which have not reached the target state at completion
+    std::set<DDSTask::Id> notBound;
+    for (auto const& device : state)
+    {
+        if (device.state != DeviceState::Bound)
+        {
+            notBound.insert(device.taskId);
+        }
+    }
+    std::set<DDSTask::Id> expected;
+    for (auto const& task : processors)
+    {
+        expected.insert(task.GetId());
+    }
+    BOOST_CHECK(notBound == expected);
+    BOOST_CHECK(std::set<DDSTask::Id>(laggards.cbegin(), laggards.cend()) == expected);
+    BOOST_CHECK_EQUAL(laggards.size(), processors.size());
+}
+
+BOOST_AUTO_TEST_CASE(async_change_state_quorum_collection)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    Topology topo(f.mDDSTopo, f.mDDSSession);
+    auto const numDevices = topo.GetCurrentState().size();
+    // only the collection is set, it is complete once all of its devices have reached the target state
+    ChangeStateQuorum quorum;
+    quorum.requiredCollections.push_back(topo.GetTasks().at(0).GetCollectionId());
+    SharedSemaphore blocker;
+    std::error_code ec;
+    FairMQTopologyState state;
+    std::vector<DDSTask::Id> laggards;
+    topo.AsyncChangeState(TopologyTransition::InitDevice,
+                          "",
+                          std::chrono::seconds(30),
+                          quorum,
+                          [&, blocker](std::error_code _ec,
+                                       FairMQTopologyState _state,
+                                       std::vector<DDSTask::Id> _laggards) mutable
+                          {
+                              ec = _ec;
+                              state = std::move(_state);
+                              laggards = std::move(_laggards);
+                              blocker.Signal();
+                          });
+    blocker.Wait();
+
+    BOOST_CHECK_EQUAL(ec, std::error_code());
+    BOOST_CHECK_EQUAL(state.size(), numDevices);
+    BOOST_CHECK(laggards.empty());
+    BOOST_CHECK_EQUAL(AggregateState(state), AggregatedTopologyState::InitializingDevice);
+}
+
 BOOST_AUTO_TEST_CASE(async_change_state_collection_view)
 {
     BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
@@ -427,6 +596,318 @@ BOOST_AUTO_TEST_CASE(change_state_full_device_lifecycle2)
     }
 }
 
+BOOST_AUTO_TEST_CASE(change_state_sequence)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    Topology topo(f.mDDSTopo, f.mDDSSession);
+    auto const configured = topo.ChangeStateSequence({ TopologyTransition::InitDevice,
+                                                       TopologyTransition::CompleteInit,
+                                                       TopologyTransition::Bind,
+                                                       TopologyTransition::Connect,
+                                                       TopologyTransition::InitTask });
+    BOOST_REQUIRE_EQUAL(configured.first, std::error_code());
+    BOOST_CHECK_EQUAL(AggregateState(configured.second), AggregatedTopologyState::Ready);
+    BOOST_CHECK(topo.StateEqualsTo(DeviceState::Ready));
+
+    auto const reset = topo.ChangeStateSequence({ TopologyTransition::ResetTask, TopologyTransition::ResetDevice });
+    BOOST_REQUIRE_EQUAL(reset.first, std::error_code());
+    BOOST_CHECK(topo.StateEqualsTo(DeviceState::Idle));
+
+    BOOST_CHECK_THROW(topo.ChangeStateSequence({}), RuntimeError);
+}
+
+BOOST_AUTO_TEST_CASE(change_state_to)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    Topology topo(f.mDDSTopo, f.mDDSSession);
+    auto const running = topo.ChangeStateTo(DeviceState::Running);
+    BOOST_REQUIRE_EQUAL(running.first, std::error_code());
+    BOOST_CHECK_EQUAL(AggregateState(running.second), AggregatedTopologyState::Running);
+
+    // walks down through Ready and DeviceReady
+    BOOST_REQUIRE_EQUAL(topo.ChangeStateTo(DeviceState::Idle).first, std::error_code());
+    BOOST_CHECK(topo.StateEqualsTo(DeviceState::Idle));
+
+    // already there
+    BOOST_REQUIRE_EQUAL(topo.ChangeStateTo(DeviceState::Idle).first, std::error_code());
+    BOOST_CHECK(topo.StateEqualsTo(DeviceState::Idle));
+}
+
+BOOST_AUTO_TEST_CASE(last_transition_stats)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    Topology topo(f.mDDSTopo, f.mDDSSession);
+    auto const numDevices = topo.GetCurrentState().size();
+    BOOST_CHECK_EQUAL(topo.GetLastTransitionStats().reached, 0);
+
+    BOOST_REQUIRE_EQUAL(topo.ChangeState(TopologyTransition::InitDevice).first, std::error_code());
+    auto const stats = topo.GetLastTransitionStats(2);
+    BOOST_TEST_MESSAGE(stats.transition << ": p50 " << stats.p50.count() << " us, max " << stats.max.count() << " us");
+    BOOST_CHECK_EQUAL(stats.reached, numDevices);
+    BOOST_CHECK_EQUAL(stats.pending, 0);
+    BOOST_CHECK_LE(stats.p50.count(), stats.p95.count());
+    BOOST_CHECK_LE(stats.p95.count(), stats.p99.count());
+    BOOST_CHECK_LE(stats.p99.count(), stats.max.count());
+    BOOST_REQUIRE_EQUAL(stats.slowest.size(), std::min<std::size_t>(2, numDevices));
+    BOOST_CHECK_EQUAL(stats.slowest.front().latency.count(), stats.max.count());
+}
+
+BOOST_AUTO_TEST_CASE(async_change_state_latencies)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    Topology topo(f.mIoContext.get_executor(), f.mDDSTopo, f.mDDSSession);
+    auto const numDevices = topo.GetCurrentState().size();
+    // the latency handler runs on the thread delivering the last state change
+    std::atomic<std::size_t> numReports(0);
+    std::atomic<bool> completed(false);
+    ProgressOptions progress;
+    progress.latencyTopK = 1;
+    progress.latencyHandler = [&](const TransitionLatencyStats& stats)
+    {
+        ++numReports;
+        BOOST_CHECK(!completed);
+        BOOST_CHECK_EQUAL(stats.reached, numDevices);
+        BOOST_CHECK_EQUAL(stats.pending, 0);
+        BOOST_CHECK_EQUAL(stats.slowest.size(), 1);
+    };
+    topo.AsyncChangeState(TopologyTransition::InitDevice,
+                          "",
+                          std::chrono::milliseconds(0),
+                          progress,
+                          [&](std::error_code ec, FairMQTopologyState)
+                          {
+                              completed = true;
+                              BOOST_CHECK_EQUAL(ec, std::error_code());
+                          });
+
+    f.mIoContext.run();
+    BOOST_CHECK(completed);
+    BOOST_CHECK_EQUAL(numReports.load(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(state_change_observer)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    Topology topo(f.mDDSTopo, f.mDDSSession);
+    auto const numDevices = topo.GetCurrentState().size();
+    std::mutex mtx;
+    std::unordered_map<DDSTask::Id, DeviceState> observed;
+    auto const id = topo.SubscribeStateChanges("",
+                                               [&](const std::vector<DeviceStateChange>& changes)
+                                               {
+                                                   std::lock_guard<std::mutex> lk(mtx);
+                                                   for (auto const& change : changes)
+                                                   {
+                                                       observed[change.taskId] = change.state;
+                                                   }
+                                               });
+
+    BOOST_REQUIRE_EQUAL(topo.ChangeState(TopologyTransition::InitDevice).first, std::error_code());
+    BOOST_REQUIRE_EQUAL(topo.ChangeState(TopologyTransition::CompleteInit).first, std::error_code());
+    BOOST_CHECK(topo.UnsubscribeStateChanges(id));
+    BOOST_CHECK(!topo.UnsubscribeStateChanges(id));
+
+    // deliveries are asynchronous, the final state of every device arrives eventually
+    for (int i = 0; i < 100; ++i)
+    {
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            if (observed.size() == numDevices
+                && std::all_of(observed.cbegin(),
+                               observed.cend(),
+                               [](auto const& entry) { return entry.second == DeviceState::Initialized; }))
+            {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::lock_guard<std::mutex> lk(mtx);
+    BOOST_CHECK_EQUAL(observed.size(), numDevices);
+}
+
+BOOST_AUTO_TEST_CASE(coalesced_state_changes)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    using namespace std::chrono_literals;
+    Topology topo(f.mDDSTopo, f.mDDSSession);
+    auto const sampler = topo.GetTasks(".*/Sampler.*").at(0).GetId();
+    auto const sink = topo.GetTasks(".*/Sink.*").at(0).GetId();
+
+    // the sink is awaited in an intermediate state of the batch, the sampler only in its last one
+    auto sinkInitializing = topo.AsyncWaitForState(
+        DeviceState::Idle, DeviceState::InitializingDevice, ".*/Sink.*", 5s, boost::asio::use_future);
+    auto sinkBound = topo.AsyncWaitForState(
+        DeviceState::Undefined, DeviceState::Bound, ".*/Sink.*", 5s, boost::asio::use_future);
+    auto samplerBound = topo.AsyncWaitForState(
+        DeviceState::Undefined, DeviceState::Bound, ".*/Sampler.*", 5s, boost::asio::use_future);
+
+    std::vector<CommandIngress::Item> batch;
+    auto push = [&](DDSTask::Id taskId, DeviceState last, DeviceState current)
+    {
+        odc::cc::Cmds const cmds(odc::cc::make<odc::cc::StateChange>("", taskId, last, current));
+        batch.push_back({ cmds.Serialize(), 0 });
+    };
+    for (auto const& [last, current] : { std::pair(DeviceState::Idle, DeviceState::InitializingDevice),
+                                         std::pair(DeviceState::InitializingDevice, DeviceState::Initialized),
+                                         std::pair(DeviceState::Initialized, DeviceState::Binding),
+                                         std::pair(DeviceState::Binding, DeviceState::Bound) })
+    {
+        push(sink, last, current);
+        push(sampler, last, current);
+    }
+    topo.HandleCommands(batch);
+
+    BOOST_CHECK_NO_THROW(sinkInitializing.get());
+    BOOST_CHECK_NO_THROW(sinkBound.get());
+    BOOST_CHECK_NO_THROW(samplerBound.get());
+    for (auto const& device : topo.GetCurrentState())
+    {
+        if (device.taskId == sink || device.taskId == sampler)
+        {
+            BOOST_CHECK_EQUAL(device.lastState, DeviceState::Binding);
+            BOOST_CHECK_EQUAL(device.state, DeviceState::Bound);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(coalesced_state_changes_after_crash)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    using namespace std::chrono_literals;
+    Topology topo(f.mDDSTopo, f.mDDSSession);
+    // the task done events of the crash are applied while the batch below is still collected
+    crash_processors(topo);
+    auto const processor = topo.GetTasks(".*/Processor.*").at(0).GetId();
+    auto const sink = topo.GetTasks(".*/Sink.*").at(0).GetId();
+
+    auto sinkBinding = topo.AsyncWaitForState(
+        DeviceState::Initialized, DeviceState::Binding, ".*/Sink.*", 5s, boost::asio::use_future);
+    auto sinkBound = topo.AsyncWaitForState(
+        DeviceState::Binding, DeviceState::Bound, ".*/Sink.*", 5s, boost::asio::use_future);
+
+    std::vector<CommandIngress::Item> batch;
+    for (auto const& [last, current] : { std::pair(DeviceState::Initialized, DeviceState::Binding),
+                                         std::pair(DeviceState::Binding, DeviceState::Bound) })
+    {
+        for (auto const taskId : { processor, sink })
+        {
+            odc::cc::Cmds const cmds(odc::cc::make<odc::cc::StateChange>("", taskId, last, current));
+            batch.push_back({ cmds.Serialize(), 0 });
+        }
+    }
+    topo.HandleCommands(batch);
+
+    BOOST_CHECK_NO_THROW(sinkBinding.get());
+    BOOST_CHECK_NO_THROW(sinkBound.get());
+    for (auto const& device : topo.GetCurrentState())
+    {
+        if (device.taskId == processor)
+        {
+            // the latest state change of the processor is not applied over its crash
+            BOOST_CHECK_EQUAL(device.state, DeviceState::Error);
+        }
+        else if (device.taskId == sink)
+        {
+            BOOST_CHECK_EQUAL(device.state, DeviceState::Bound);
+        }
+    }
+}
+
+/// Ids of the runtime tasks of the DDS topology matching path, without going through a Topology
+auto match_task_ids(dds::topology_api::CTopology& ddsTopo, const std::string& path) -> std::set<DDSTask::Id>
+{
+    auto const itPair = path.empty() ? ddsTopo.getRuntimeTaskIterator(nullptr)
+                                     : ddsTopo.getRuntimeTaskIteratorMatchingPath(path);
+    std::set<DDSTask::Id> ids;
+    for (auto it = itPair.first; it != itPair.second; ++it)
+    {
+        ids.insert(it->first);
+    }
+    return ids;
+}
+
+auto get_task_ids(Topology& topo, const std::string& path) -> std::set<DDSTask::Id>
+{
+    std::set<DDSTask::Id> ids;
+    for (auto const& task : topo.GetTasks(path))
+    {
+        ids.insert(task.GetId());
+    }
+    return ids;
+}
+
+BOOST_AUTO_TEST_CASE(selection_cache)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    Topology topo(f.mDDSTopo, f.mDDSSession);
+    for (std::string const path : { "", ".*/Sampler.*", ".*/Processor.*", ".*/Sink.*", "no-such-task" })
+    {
+        auto const expected = match_task_ids(f.mDDSTopo, path);
+        BOOST_CHECK(get_task_ids(topo, path) == expected);
+        // second call is served from the cache
+        BOOST_CHECK(get_task_ids(topo, path) == expected);
+    }
+
+    BOOST_REQUIRE_EQUAL(topo.ChangeState(TopologyTransition::InitDevice, ".*/Processor.*").first, std::error_code());
+    BOOST_CHECK_EQUAL(topo.AggregateState(".*/Processor.*"), AggregatedTopologyState::InitializingDevice);
+    BOOST_CHECK_EQUAL(topo.AggregateState(".*/Sink.*"), AggregatedTopologyState::Idle);
+    BOOST_CHECK_EQUAL(topo.AggregateState(""), AggregatedTopologyState::Mixed);
+    // the path of a single task
+    auto const itPair = f.mDDSTopo.getRuntimeTaskIteratorMatchingPath(".*/Processor.*");
+    BOOST_REQUIRE(itPair.first != itPair.second);
+    auto const& processorPath = itPair.first->second.m_taskPath;
+    BOOST_CHECK_EQUAL(topo.AggregateState(processorPath), AggregatedTopologyState::InitializingDevice);
+    BOOST_CHECK_THROW(topo.AggregateState("no-such-task"), RuntimeError);
+}
+
+BOOST_AUTO_TEST_CASE(selection_cache_cap)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    Topology topo(f.mDDSTopo, f.mDDSSession);
+    auto const sinks = match_task_ids(f.mDDSTopo, ".*/Sink.*");
+    // distinct paths selecting the same tasks
+    int i = 0;
+    auto next_path = [&i]() { return ".*/Sink.*|no-such-task-" + std::to_string(i++); };
+    while (topo.GetNumCachedSelections() < Topology::fMaxCachedSelections)
+    {
+        BOOST_REQUIRE(get_task_ids(topo, next_path()) == sinks);
+    }
+    BOOST_CHECK_EQUAL(topo.GetNumCachedSelections(), Topology::fMaxCachedSelections);
+
+    BOOST_CHECK(get_task_ids(topo, next_path()) == sinks);
+    BOOST_CHECK_EQUAL(topo.GetNumCachedSelections(), 1);
+    BOOST_CHECK(get_task_ids(topo, ".*/Sink.*") == sinks);
+    BOOST_CHECK_EQUAL(topo.GetNumCachedSelections(), 2);
+}
+
 BOOST_AUTO_TEST_CASE(set_properties)
 {
     BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
@@ -668,6 +1149,81 @@ BOOST_AUTO_TEST_CASE(device_crashed)
     BOOST_TEST_CHECKPOINT("Topology destructed.");
 }
 
+BOOST_AUTO_TEST_CASE(stale_state_change_after_crash)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    Topology topo(f.mDDSTopo, f.mDDSSession);
+    crash_processors(topo);
+
+    // a state change the processor has sent before crashing, arriving after its task done event
+    auto const processor = topo.GetTasks(".*/Processor.*").at(0).GetId();
+    odc::cc::Cmds const cmds(
+        odc::cc::make<odc::cc::StateChange>("", processor, DeviceState::InitializingDevice, DeviceState::Initialized));
+    std::vector<CommandIngress::Item> batch{ { cmds.Serialize(), 0 } };
+    topo.HandleCommands(batch);
+
+    for (auto const& device : topo.GetCurrentState())
+    {
+        if (device.taskId == processor)
+        {
+            BOOST_CHECK_EQUAL(device.state, DeviceState::Error);
+        }
+    }
+    // the crash still fails the next transition right away
+    BOOST_CHECK_EQUAL(topo.ChangeState(TopologyTransition::Bind).first,
+                      MakeErrorCode(ErrorCode::DeviceChangeStateFailed));
+}
+
+BOOST_AUTO_TEST_CASE(device_failure_policy_fail_fast)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    Topology topo(f.mDDSTopo, f.mDDSSession);
+    BOOST_REQUIRE(topo.GetDeviceFailurePolicy() == DeviceFailurePolicy::FailFast);
+    crash_processors(topo);
+
+    // the processors have failed before the operation, it does not wait for the others
+    auto const result(topo.ChangeState(TopologyTransition::Bind));
+    BOOST_CHECK_EQUAL(result.first, MakeErrorCode(ErrorCode::DeviceChangeStateFailed));
+    BOOST_REQUIRE_EQUAL(topo.WaitForState(DeviceState::Bound, ".*/(Sampler|Sink).*"), std::error_code());
+}
+
+BOOST_AUTO_TEST_CASE(device_failure_policy_exclude)
+{
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    Topology topo(f.mDDSTopo, f.mDDSSession);
+    crash_processors(topo);
+    topo.SetDeviceFailurePolicy(DeviceFailurePolicy::Exclude);
+
+    auto const result(topo.ChangeState(TopologyTransition::Bind));
+    BOOST_CHECK_EQUAL(result.first, MakeErrorCode(ErrorCode::DevicesExcluded));
+    check_all_but_processors_in(topo, result.second, DeviceState::Bound);
+}
+
+BOOST_AUTO_TEST_CASE(device_failure_policy_wait)
+{
+    using namespace std::chrono_literals;
+    BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
+    BOOST_REQUIRE_EQUAL(framework::master_test_suite().argv[1], "--topo-file");
+    TopologyFixture f(framework::master_test_suite().argv[2]);
+
+    Topology topo(f.mDDSTopo, f.mDDSSession);
+    crash_processors(topo);
+    topo.SetDeviceFailurePolicy(DeviceFailurePolicy::Wait);
+
+    auto const result(topo.ChangeState(TopologyTransition::Bind, "", 3s));
+    BOOST_CHECK_EQUAL(result.first, MakeErrorCode(ErrorCode::OperationTimeout));
+    check_all_but_processors_in(topo, result.second, DeviceState::Bound);
+}
+
 BOOST_AUTO_TEST_CASE(underlying_session_terminated)
 {
     BOOST_REQUIRE(framework::master_test_suite().argc >= 3);
@@ -800,3 +1356,318 @@ BOOST_AUTO_TEST_CASE(change_state_full_lifecycle_concurrent)
 }
 
 BOOST_AUTO_TEST_SUITE_END(); // multiple_topologies
+
+BOOST_AUTO_TEST_SUITE(state_kernels);
+
+const std::array<StateKernelIsa, 3> allIsas{ StateKernelIsa::Scalar, StateKernelIsa::SSE2, StateKernelIsa::AVX2 };
+
+// sizes around the vector widths and the 64 state chunks
+const std::array<std::size_t, 9> testSizes{ 0, 1, 15, 16, 33, 63, 64, 65, 1000 };
+
+auto make_states(std::size_t size) -> std::vector<std::uint8_t>
+{
+    std::vector<std::uint8_t> states(size, static_cast<std::uint8_t>(DeviceState::Ready));
+    for (std::size_t i = 0; i < size; i += 7)
+    {
+        states[i] = static_cast<std::uint8_t>(i % 16);
+    }
+    return states;
+}
+
+BOOST_AUTO_TEST_CASE(all_states_equal)
+{
+    auto const ready = static_cast<std::uint8_t>(DeviceState::Ready);
+    for (auto const isa : allIsas)
+    {
+        BOOST_TEST_MESSAGE("Using " << GetStateKernelIsaName(SetStateKernelIsa(isa)));
+        for (auto const size : testSizes)
+        {
+            std::vector<std::uint8_t> states(size, ready);
+            BOOST_CHECK(AllStatesEqual(states.data(), size, ready));
+            if (size > 0)
+            {
+                states.back() = static_cast<std::uint8_t>(DeviceState::Error);
+                BOOST_CHECK(!AllStatesEqual(states.data(), size, ready));
+            }
+        }
+    }
+    SetStateKernelIsa(StateKernelIsa::AVX2);
+}
+
+BOOST_AUTO_TEST_CASE(count_states)
+{
+    for (auto const isa : allIsas)
+    {
+        BOOST_TEST_MESSAGE("Using " << GetStateKernelIsaName(SetStateKernelIsa(isa)));
+        for (auto const size : testSizes)
+        {
+            auto const states = make_states(size);
+            std::array<std::size_t, 16> expected{};
+            for (auto const s : states)
+            {
+                ++expected.at(s);
+            }
+            std::array<std::size_t, 16> counts{};
+            CountStates(states.data(), size, counts.data(), counts.size());
+            BOOST_CHECK(counts == expected);
+        }
+    }
+    SetStateKernelIsa(StateKernelIsa::AVX2);
+}
+
+BOOST_AUTO_TEST_CASE(mismatches_and_mask)
+{
+    auto const ready = static_cast<std::uint8_t>(DeviceState::Ready);
+    for (auto const isa : allIsas)
+    {
+        BOOST_TEST_MESSAGE("Using " << GetStateKernelIsaName(SetStateKernelIsa(isa)));
+        for (auto const size : testSizes)
+        {
+            auto const states = make_states(size);
+            std::vector<std::size_t> expected;
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                if (states[i] != ready)
+                {
+                    expected.push_back(i);
+                }
+            }
+            BOOST_CHECK(FindStateMismatches(states.data(), size, ready) == expected);
+
+            std::vector<std::uint64_t> mask((size + 63) / 64, ~std::uint64_t(0));
+            StatesEqualMask(states.data(), size, ready, mask.data());
+            for (std::size_t i = 0; i < mask.size() * 64; ++i)
+            {
+                bool const bit = (mask[i / 64] >> (i % 64)) & 1;
+                BOOST_CHECK_EQUAL(bit, i < size && states[i] == ready);
+            }
+        }
+    }
+    SetStateKernelIsa(StateKernelIsa::AVX2);
+}
+
+BOOST_AUTO_TEST_CASE(large_inputs)
+{
+    // beyond the 255 iteration flush of the 8-bit lane counters (4080 and 8160 states), with a tail
+    auto const ready = static_cast<std::uint8_t>(DeviceState::Ready);
+    const std::array<std::size_t, 5> largeSizes{ 4081, 4097, 8161, 8193, 10007 };
+    for (auto const size : largeSizes)
+    {
+        for (auto const& states : { make_states(size), std::vector<std::uint8_t>(size, ready) })
+        {
+            SetStateKernelIsa(StateKernelIsa::Scalar);
+            std::array<std::size_t, 16> expectedCounts{};
+            CountStates(states.data(), size, expectedCounts.data(), expectedCounts.size());
+            auto const expectedEqual = AllStatesEqual(states.data(), size, ready);
+            auto const expectedMismatches = FindStateMismatches(states.data(), size, ready);
+            BOOST_CHECK_EQUAL(expectedCounts.at(ready), size - expectedMismatches.size());
+
+            for (auto const isa : allIsas)
+            {
+                BOOST_TEST_MESSAGE("Using " << GetStateKernelIsaName(SetStateKernelIsa(isa)) << " for " << size
+                                            << " states");
+                std::array<std::size_t, 16> counts{};
+                CountStates(states.data(), size, counts.data(), counts.size());
+                BOOST_CHECK(counts == expectedCounts);
+                BOOST_CHECK_EQUAL(AllStatesEqual(states.data(), size, ready), expectedEqual);
+                BOOST_CHECK(FindStateMismatches(states.data(), size, ready) == expectedMismatches);
+            }
+        }
+    }
+    SetStateKernelIsa(StateKernelIsa::AVX2);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // state_kernels
+
+BOOST_AUTO_TEST_SUITE(state_table);
+
+/// Topology state of the given number of Idle devices
+auto make_topology_state(std::size_t size) -> FairMQTopologyState
+{
+    FairMQTopologyState state;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        state.push_back(DeviceStatus{ false, DeviceState::Undefined, DeviceState::Idle, i + 1, 0, -1, -1 });
+    }
+    return state;
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_version)
+{
+    DeviceStateTable table(make_topology_state(300));
+    auto const first = table.Snapshot();
+    BOOST_CHECK_EQUAL(table.Snapshot(), first);
+
+    table.Modify(200, [](DeviceStatus& status) { status.state = DeviceState::InitializingDevice; });
+    auto const second = table.Snapshot();
+    BOOST_CHECK_NE(second->version, first->version);
+    BOOST_CHECK_EQUAL(second->state.at(200).state, DeviceState::InitializingDevice);
+    BOOST_CHECK_EQUAL(table.Snapshot(), second);
+    // a published snapshot is never modified
+    BOOST_CHECK_EQUAL(first->state.at(200).state, DeviceState::Idle);
+
+    // a modification leaving the state as is still publishes a new version
+    table.Modify(0, [](DeviceStatus& status) { status.exitCode = 0; });
+    auto const third = table.Snapshot();
+    BOOST_CHECK_NE(third->version, second->version);
+    BOOST_CHECK_EQUAL(third->state.at(0).exitCode, 0);
+}
+
+BOOST_AUTO_TEST_CASE(state_counts)
+{
+    DeviceStateTable table(make_topology_state(300));
+    auto check_counts = [&table]()
+    {
+        std::size_t sum = 0;
+        // AggregatedTopologyState::Mixed directly follows the last DeviceState
+        for (int s = 0; s < static_cast<int>(AggregatedTopologyState::Mixed); ++s)
+        {
+            sum += table.GetStateCount(static_cast<DeviceState>(s));
+        }
+        BOOST_CHECK_EQUAL(sum, table.Size());
+    };
+    check_counts();
+    BOOST_CHECK_EQUAL(table.GetStateCount(DeviceState::Idle), 300);
+    BOOST_CHECK_EQUAL(table.AggregateState(), AggregatedTopologyState::Idle);
+
+    for (auto const state : { DeviceState::InitializingDevice, DeviceState::Initialized, DeviceState::Binding })
+    {
+        for (std::size_t i = 0; i < table.Size(); i += 2)
+        {
+            table.Modify(i, [state](DeviceStatus& status) { status.state = state; });
+            check_counts();
+        }
+        BOOST_CHECK_EQUAL(table.GetStateCount(state), 150);
+        BOOST_CHECK_EQUAL(table.AggregateState(), AggregatedTopologyState::Mixed);
+    }
+    BOOST_CHECK_EQUAL(table.GetStateCount(DeviceState::InitializingDevice), 0);
+    BOOST_CHECK_EQUAL(table.GetStateCount(DeviceState::Initialized), 0);
+
+    for (std::size_t i = 1; i < table.Size(); i += 2)
+    {
+        table.Modify(i, [](DeviceStatus& status) { status.state = DeviceState::Binding; });
+    }
+    check_counts();
+    BOOST_CHECK_EQUAL(table.GetStateCount(DeviceState::Idle), 0);
+    BOOST_CHECK_EQUAL(table.AggregateState(), AggregatedTopologyState::Binding);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // state_table
+
+BOOST_AUTO_TEST_SUITE(command_ingress);
+
+BOOST_AUTO_TEST_CASE(ordered_batches)
+{
+    constexpr std::uint64_t numProducers = 4;
+    constexpr int numMessages = 10000;
+    std::array<int, numProducers> next{};
+    std::size_t numReceived = 0;
+    bool ordered = true;
+    {
+        CommandIngress ingress(
+            [&](std::vector<CommandIngress::Item>& batch)
+            {
+                BOOST_CHECK_LE(batch.size(), 64u);
+                for (auto const& item : batch)
+                {
+                    ordered = ordered && std::stoi(item.msg) == next.at(item.senderId)++;
+                    ++numReceived;
+                }
+            },
+            64);
+        std::vector<std::thread> producers;
+        for (std::uint64_t p = 0; p < numProducers; ++p)
+        {
+            producers.emplace_back(
+                [&ingress, p]()
+                {
+                    for (int i = 0; i < numMessages; ++i)
+                    {
+                        ingress.Push(std::to_string(i), p);
+                    }
+                });
+        }
+        for (auto& producer : producers)
+        {
+            producer.join();
+        }
+        ingress.Stop();
+    }
+    BOOST_CHECK(ordered);
+    BOOST_CHECK_EQUAL(numReceived, numProducers * numMessages);
+}
+
+BOOST_AUTO_TEST_CASE(coalescing_window)
+{
+    std::size_t numBatches = 0;
+    std::size_t numReceived = 0;
+    {
+        CommandIngress ingress(
+            [&](std::vector<CommandIngress::Item>& batch)
+            {
+                ++numBatches;
+                numReceived += batch.size();
+            });
+        ingress.SetCoalescingWindow(std::chrono::milliseconds(50));
+        for (int i = 0; i < 100; ++i)
+        {
+            ingress.Push(std::to_string(i), 0);
+        }
+        ingress.Stop();
+    }
+    BOOST_CHECK_EQUAL(numReceived, 100);
+    // the messages arrive well within one window, but the decoder may have woken up on the very first one
+    BOOST_CHECK_LE(numBatches, 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // command_ingress
+
+BOOST_AUTO_TEST_SUITE(task_path_condition);
+
+BOOST_AUTO_TEST_CASE(exact_match)
+{
+    std::regex const processor(ExactTaskPathCondition("main/Pipeline_1/Processor_1"));
+    BOOST_CHECK(std::regex_search("main/Pipeline_1/Processor_1", processor));
+    BOOST_CHECK(!std::regex_search("main/Pipeline_1/Processor_10", processor));
+    BOOST_CHECK(!std::regex_search("main/Pipeline_11/Processor_1", processor));
+    BOOST_CHECK(!std::regex_search("x/main/Pipeline_1/Processor_1", processor));
+
+    std::regex const special(ExactTaskPathCondition("main/a.b(c)[1]+"));
+    BOOST_CHECK(std::regex_search("main/a.b(c)[1]+", special));
+    BOOST_CHECK(!std::regex_search("main/axbc1", special));
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // task_path_condition
+
+BOOST_AUTO_TEST_SUITE(timer_wheel);
+
+BOOST_AUTO_TEST_CASE(expiry_and_cancel)
+{
+    AsyncOpFixture f;
+    // 8 slots of 5 ms, the longer timeouts need several rounds of the wheel
+    auto wheel = std::make_shared<TimerWheel>(f.mIoContext.get_executor(), std::chrono::milliseconds(5), 8);
+    auto const start = std::chrono::steady_clock::now();
+
+    std::size_t numExpired = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        std::chrono::milliseconds const timeout((i % 10) * 11 + 1);
+        wheel->Schedule(timeout,
+                        [&, timeout]()
+                        {
+                            BOOST_CHECK(std::chrono::steady_clock::now() - start >= timeout);
+                            ++numExpired;
+                        });
+    }
+    auto const cancelled =
+        wheel->Schedule(std::chrono::milliseconds(20), []() { BOOST_FAIL("cancelled timer expired"); });
+    BOOST_CHECK_EQUAL(wheel->GetSize(), 101);
+    BOOST_CHECK(wheel->Cancel(cancelled));
+    BOOST_CHECK(!wheel->Cancel(cancelled));
+
+    f.mIoContext.run();
+    BOOST_CHECK_EQUAL(numExpired, 100);
+    BOOST_CHECK_EQUAL(wheel->GetSize(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END(); // timer_wheel
@@ -0,0 +1,123 @@
+// Copyright 2020-2021 GSI, Inc. All rights reserved.
+//
+// Microbenchmark of the device state scan kernels for the available instruction sets.
+//
+
+#include "StateKernels.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace odc::core;
+using namespace std;
+
+namespace
+{
+    constexpr uint8_t ready = 11;    // fair::mq::State::Ready
+    constexpr size_t numStates = 16; // number of fair::mq::State values
+
+    // Keeps the optimizer from discarding kernel results
+    volatile size_t gSink = 0;
+
+    template <typename Func>
+    auto measure(size_t size, Func&& func) -> double
+    {
+        // aim at roughly 100M processed states per measurement
+        size_t const iterations = max<size_t>(10, 100'000'000 / size);
+        func(); // warm up
+        auto const start = chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            func();
+        }
+        chrono::duration<double, nano> const elapsed = chrono::steady_clock::now() - start;
+        return elapsed.count() / iterations;
+    }
+
+    struct Result
+    {
+        double allEqual;
+        double count;
+        double mask;
+        double mismatches;
+    };
+
+    auto run(size_t size) -> Result
+    {
+        // all devices ready, except every 100th one
+        vector<uint8_t> states(size, ready);
+        for (size_t i = 0; i < size; i += 100)
+        {
+            states[i] = 2; // fair::mq::State::Error
+        }
+        vector<uint8_t> const allReady(size, ready);
+        vector<uint64_t> mask((size + 63) / 64);
+        array<size_t, numStates> counts{};
+
+        Result result;
+        result.allEqual = measure(size, [&]() { gSink = gSink + AllStatesEqual(allReady.data(), size, ready); });
+        result.count = measure(size,
+                               [&]()
+                               {
+                                   CountStates(states.data(), size, counts.data(), counts.size());
+                                   gSink = gSink + counts[ready];
+                               });
+        result.mask = measure(size,
+                              [&]()
+                              {
+                                  StatesEqualMask(states.data(), size, ready, mask.data());
+                                  gSink = gSink + mask.back();
+                              });
+        result.mismatches =
+            measure(size, [&]() { gSink = gSink + FindStateMismatches(states.data(), size, ready).size(); });
+        return result;
+    }
+} // namespace
+
+int main()
+{
+    array<size_t, 3> const sizes{ 1000, 10000, 100000 };
+    array<StateKernelIsa, 3> const isas{ StateKernelIsa::Scalar, StateKernelIsa::SSE2, StateKernelIsa::AVX2 };
+
+    cout << "Time per call in ns (speedup over scalar)" << endl;
+    cout << setw(8) << "devices" << setw(8) << "isa" << setw(20) << "all equal" << setw(20) << "count states"
+         << setw(20) << "equal mask" << setw(20) << "mismatches" << endl;
+
+    for (auto const size : sizes)
+    {
+        Result scalar{};
+        for (auto const isa : isas)
+        {
+            auto const used = SetStateKernelIsa(isa);
+            if (used != isa)
+            {
+                cout << setw(8) << size << setw(8) << GetStateKernelIsaName(isa) << "  not supported" << endl;
+                continue;
+            }
+            auto const r = run(size);
+            if (isa == StateKernelIsa::Scalar)
+            {
+                scalar = r;
+            }
+            auto print = [](double t, double ref)
+            {
+                stringstream ss;
+                ss << fixed << setprecision(0) << t << " (" << setprecision(1) << ref / t << "x)";
+                cout << setw(20) << ss.str();
+            };
+            cout << setw(8) << size << setw(8) << GetStateKernelIsaName(isa);
+            print(r.allEqual, scalar.allEqual);
+            print(r.count, scalar.count);
+            print(r.mask, scalar.mask);
+            print(r.mismatches, scalar.mismatches);
+            cout << endl;
+        }
+    }
+
+    return 0;
+}